@@ -51,6 +51,7 @@
     "target_name": "plugin",
     "type": "shared_library",
     "sources": [
+      "src/backtrace.cc",
       "src/constants.cc",
       "src/error.cc",
       "src/llnode.cc",
@@ -79,11 +80,12 @@
         "include_dirs": [
           "<!@(node -p \"require('node-addon-api').include\")"
         ],
-        "defines": [ "NAPI_DISABLE_CPP_EXCEPTIONS", "NO_COLOR_OUTPUT" ],
+        "defines": [ "NAPI_DISABLE_CPP_EXCEPTIONS", "NAPI_VERSION=6", "NO_COLOR_OUTPUT" ],
         "sources": [
           "src/addon.cc",
           "src/llnode_module.cc",
           "src/llnode_api.cc",
+          "src/backtrace.cc",
           "src/constants.cc",
           "src/error.cc",
           "src/llv8.cc",
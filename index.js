@@ -1,6 +1,7 @@
 'use strict';
 
 const {
+  collapseStacks,
   fromCoredump,
   LLNodeHeapType,
   nextInstance
@@ -24,5 +25,6 @@ Object.defineProperty(LLNodeHeapType.prototype, 'instances', {
 });
 
 module.exports = {
+  collapseStacks,
   fromCoredump
 }
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <cinttypes>
+
+#include "src/backtrace.h"
+#include "src/llv8-inl.h"
+
+namespace llnode {
+
+using lldb::SBFrame;
+using lldb::SBProcess;
+using lldb::SBStream;
+using lldb::SBTarget;
+using lldb::SBThread;
+
+void FrameDecoder::Load(SBTarget target) {
+  // Load V8 constants from postmortem data
+  llv8_->Load(target);
+  code_map_->Load(target);
+
+  // Heap addresses only stay put while the process is stopped.
+  SBProcess process = target.GetProcess();
+  if (process_id_ != process.GetUniqueID() ||
+      stop_id_ != process.GetStopID()) {
+    debug_lines_.clear();
+    process_id_ = process.GetUniqueID();
+    stop_id_ = process.GetStopID();
+  }
+}
+
+
+FrameDecoder::Kind FrameDecoder::Decode(SBFrame frame, Style style,
+                                        std::string& res) {
+  const uint64_t pc = frame.GetPC();
+
+  if (v8::JSFrame::MightBeV8Frame(frame)) {
+    Error err;
+    v8::JSFrame v8_frame(llv8_, static_cast<int64_t>(frame.GetFP()));
+    Printer::PrinterOptions options;
+    options.with_args = style == kDetailed;
+    Printer printer(llv8_, options, &debug_lines_);
+    res = printer.Stringify(v8_frame, err);
+    if (err.Success()) {
+      if (style == kFolded) {
+        size_t pos = res.rfind(" fn=0x");
+        if (pos != std::string::npos) res.erase(pos);
+      }
+      return kJSFrame;
+    } else {
+      PRINT_DEBUG("%s", err.GetMessage());
+    }
+  }
+
+  // Embedded builtins, and Code objects if the heap was already scanned.
+  int64_t code = 0;
+  res = code_map_->Lookup(pc, &code);
+  if (!res.empty()) {
+    if (style == kDetailed && code != 0) {
+      char tmp[128];
+      snprintf(tmp, sizeof(tmp), " code=0x%016" PRIx64, code);
+      res += tmp;
+    }
+    return kCodeFrame;
+  }
+
+  // Heuristic: a PC in WX memory is almost certainly a V8 builtin.
+  {
+    lldb::SBMemoryRegionInfo info;
+    if (frame.GetThread().GetProcess().GetMemoryRegionInfo(pc, info)
+            .Success() &&
+        info.IsExecutable() && info.IsWritable()) {
+      res = "<builtin>";
+      return kBuiltinFrame;
+    }
+  }
+
+  // C++ stack frame.
+  res.clear();
+  if (style == kDetailed) {
+    SBStream desc;
+    if (frame.GetDescription(desc)) res = desc.GetData();
+    return kNativeFrame;
+  }
+
+  const char* name = frame.GetFunctionName();
+  if (name != nullptr) {
+    res = name;
+  } else {
+    char tmp[32];
+    snprintf(tmp, sizeof(tmp), "0x%016" PRIx64, pc);
+    res = tmp;
+  }
+  return kNativeFrame;
+}
+
+
+void FrameDecoder::AddThread(SBThread thread, StackTrie& trie) {
+  uint32_t num_frames = thread.GetNumFrames();
+  std::vector<std::string> frames(num_frames);
+
+  for (uint32_t i = 0; i < num_frames; i++) {
+    std::string& name = frames[num_frames - i - 1];
+    Decode(thread.GetFrameAtIndex(i), kFolded, name);
+    // ';' separates frames in the folded format
+    std::replace(name.begin(), name.end(), ';', ':');
+  }
+
+  if (!frames.empty()) trie.Add(frames);
+}
+
+
+void StackTrie::Add(const std::vector<std::string>& frames, uint64_t count) {
+  Node* node = &root_;
+  for (const std::string& frame : frames) {
+    std::unique_ptr<Node>& child = node->children[frame];
+    if (child == nullptr) child.reset(new Node());
+    node = child.get();
+  }
+
+  node->count += count;
+  stacks_ += count;
+}
+
+
+std::string StackTrie::Fold() const {
+  std::string prefix;
+  std::string out;
+  Fold(root_, prefix, out);
+  return out;
+}
+
+
+void StackTrie::Fold(const Node& node, std::string& prefix, std::string& out) {
+  if (node.count > 0) {
+    char tmp[32];
+    snprintf(tmp, sizeof(tmp), " %" PRIu64 "\n", node.count);
+    out += prefix + tmp;
+  }
+
+  // Sorted, so the output doesn't depend on the hash order.
+  std::vector<const std::string*> names;
+  for (auto& child : node.children) names.push_back(&child.first);
+  std::sort(names.begin(), names.end(),
+            [](const std::string* a, const std::string* b) { return *a < *b; });
+
+  for (const std::string* name : names) {
+    size_t length = prefix.size();
+    if (length != 0) prefix += ';';
+    prefix += *name;
+    Fold(*node.children.at(*name), prefix, out);
+    prefix.resize(length);
+  }
+}
+
+}  // namespace llnode
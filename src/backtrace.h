@@ -0,0 +1,76 @@
+#ifndef SRC_BACKTRACE_H_
+#define SRC_BACKTRACE_H_
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <lldb/API/LLDB.h>
+
+#include "src/llv8.h"
+#include "src/printer.h"
+
+namespace llnode {
+
+class StackTrie;
+
+// Classifies and names the frames of native threads the way `v8 bt` prints
+// them. JS functions are decoded once while the process stays stopped.
+class FrameDecoder {
+ public:
+  enum Kind { kJSFrame, kCodeFrame, kBuiltinFrame, kNativeFrame };
+  // kDetailed is what `v8 bt` prints, kFolded drops arguments and addresses
+  // so the same frame gets the same name across threads and cores.
+  enum Style { kDetailed, kFolded };
+
+  FrameDecoder(v8::LLV8* llv8, v8::CodeMap* code_map)
+      : llv8_(llv8), code_map_(code_map), process_id_(0), stop_id_(0) {}
+
+  void Load(lldb::SBTarget target);
+
+  Kind Decode(lldb::SBFrame frame, Style style, std::string& res);
+
+  // Add the stack of thread to trie, outermost frame first.
+  void AddThread(lldb::SBThread thread, StackTrie& trie);
+
+ private:
+  v8::LLV8* llv8_;
+  v8::CodeMap* code_map_;
+
+  // Decoded functions, valid until the process runs again.
+  Printer::DebugLineCache debug_lines_;
+  uint32_t process_id_;
+  uint32_t stop_id_;
+};
+
+// Stacks aggregated by frame names, printed in the folded format read by
+// flamegraph.pl: one "outermost;...;innermost count" line per stack.
+class StackTrie {
+ public:
+  StackTrie() : stacks_(0) {}
+
+  // frames are ordered outermost first.
+  void Add(const std::vector<std::string>& frames, uint64_t count = 1);
+
+  std::string Fold() const;
+  uint64_t stacks() const { return stacks_; }
+
+ private:
+  struct Node {
+    Node() : count(0) {}
+
+    // Stacks ending in this frame
+    uint64_t count;
+    std::unordered_map<std::string, std::unique_ptr<Node>> children;
+  };
+
+  static void Fold(const Node& node, std::string& prefix, std::string& out);
+
+  Node root_;
+  uint64_t stacks_;
+};
+
+}  // namespace llnode
+
+#endif  // SRC_BACKTRACE_H_
@@ -1,7 +1,17 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <cinttypes>
+#include <cstdio>
+#include <fstream>
 #include <initializer_list>
 #include <iterator>
+#include <memory>
 #include <sstream>
+#include <vector>
 
 #include <lldb/API/SBExpressionOptions.h>
 
@@ -9,6 +19,7 @@
 
 using lldb::SBAddress;
 using lldb::SBError;
+using lldb::SBModule;
 using lldb::SBSymbol;
 using lldb::SBSymbolContext;
 using lldb::SBSymbolContextList;
@@ -23,7 +34,419 @@ T ReadSymbolFromTarget(SBTarget& target, SBAddress& start, const char* name,
   return res;
 }
 
+static const char* const kIndexedPrefixes[] = {"v8dbg_", "nodedbg_"};
+
+static bool HasIndexedPrefix(const char* name) {
+  for (const char* prefix : kIndexedPrefixes) {
+    if (strncmp(name, prefix, strlen(prefix)) == 0) return true;
+  }
+  return false;
+}
+
+static bool DecodeSymbolValue(const uint8_t* data, uint32_t size,
+                              int64_t* res) {
+  // NOTE: size could be bigger for at the end symbols
+  if (size >= 8) {
+    int64_t tmp;
+    memcpy(&tmp, data, sizeof(tmp));
+    *res = tmp;
+  } else if (size == 4) {
+    int32_t tmp;
+    memcpy(&tmp, data, sizeof(tmp));
+    *res = static_cast<int64_t>(tmp);
+  } else if (size == 2) {
+    int16_t tmp;
+    memcpy(&tmp, data, sizeof(tmp));
+    *res = static_cast<int64_t>(tmp);
+  } else if (size == 1) {
+    int8_t tmp;
+    memcpy(&tmp, data, sizeof(tmp));
+    *res = static_cast<int64_t>(tmp);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+std::mutex SymbolIndex::indexes_mutex_;
+std::vector<std::unique_ptr<SymbolIndex>> SymbolIndex::indexes_;
+
+SymbolIndex* SymbolIndex::Find(SBTarget target, bool create) {
+  std::lock_guard<std::mutex> lock(indexes_mutex_);
+  for (auto& it : indexes_) {
+    if (it->target_ == target) return it.get();
+  }
+  if (!create) return nullptr;
+
+  indexes_.emplace_back(new SymbolIndex());
+  SymbolIndex* index = indexes_.back().get();
+  index->target_ = target;
+  SBModule executable = target.FindModule(target.GetExecutable());
+  if (executable.IsValid() && executable.GetUUIDString() != nullptr) {
+    index->build_id_ = executable.GetUUIDString();
+  }
+  return index;
+}
+
+SymbolIndex* SymbolIndex::Get(SBTarget target) {
+  SymbolIndex* index = Find(target, true);
+
+  // Outside of indexes_mutex_, so cores loaded in parallel don't wait on each
+  // other's symbol tables.
+  std::lock_guard<std::mutex> lock(index->load_mutex_);
+  if (!index->loaded_) {
+    index->Load();
+    index->loaded_ = true;
+  }
+  return index;
+}
+
+SymbolIndex* SymbolIndex::Import(SBTarget target, const std::string& path,
+                                 Error& err) {
+  SymbolIndex* index = Find(target, true);
+  if (index->build_id_.empty()) {
+    err = Error::Failure(
+        "Target has no build-id, can't use constants profiles");
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(index->load_mutex_);
+  if (!index->ReadProfile(path, err)) return nullptr;
+  index->loaded_ = true;
+
+  // Also keep it where the next session will look for it.
+  std::string cache_path = ProfilePath(index->build_id_, true);
+  if (!cache_path.empty() && cache_path != path &&
+      !index->ExportProfile(cache_path, err)) {
+    return nullptr;
+  }
+  index->dirty_ = false;
+  return index;
+}
+
+void SymbolIndex::Update(SBTarget target) {
+  SymbolIndex* index = Find(target, false);
+  if (index == nullptr) return;
+
+  std::lock_guard<std::mutex> lock(index->load_mutex_);
+  index->SaveProfile();
+}
+
+void SymbolIndex::Release(SBTarget target) {
+  Update(target);
+
+  std::lock_guard<std::mutex> lock(indexes_mutex_);
+  indexes_.erase(std::remove_if(indexes_.begin(), indexes_.end(),
+                                [&target](std::unique_ptr<SymbolIndex>& it) {
+                                  return it->target_ == target;
+                                }),
+                 indexes_.end());
+}
+
+bool SymbolIndex::Lookup(const char* name, Constant<int64_t>* constant) {
+  std::lock_guard<std::mutex> lock(load_mutex_);
+  auto it = values_.find(name);
+  if (it != values_.end()) {
+    *constant = Constant<int64_t>(it->second, name);
+    return true;
+  }
+
+  if (defaults_.count(name) != 0) {
+    *constant = Constant<int64_t>();
+    return true;
+  }
+
+  // Without a complete index, let the caller search for the symbol instead
+  // of assuming it doesn't exist.
+  if (indexed_ && HasIndexedPrefix(name)) {
+    defaults_.insert(name);
+    dirty_ = true;
+    *constant = Constant<int64_t>();
+    return true;
+  }
+
+  return false;
+}
+
+void SymbolIndex::Remember(const char* name, Constant<int64_t> constant) {
+  std::lock_guard<std::mutex> lock(load_mutex_);
+  if (constant.Loaded()) {
+    values_.emplace(name, *constant);
+  } else {
+    defaults_.insert(name);
+  }
+  dirty_ = true;
+}
+
+size_t SymbolIndex::loaded_count() const {
+  std::lock_guard<std::mutex> lock(load_mutex_);
+  return values_.size();
+}
+
+size_t SymbolIndex::default_count() const {
+  std::lock_guard<std::mutex> lock(load_mutex_);
+  return defaults_.size();
+}
+
+bool SymbolIndex::Export(const std::string& path, Error& err) {
+  std::lock_guard<std::mutex> lock(load_mutex_);
+  return ExportProfile(path, err);
+}
+
+void SymbolIndex::Load() {
+  const char* enabled = getenv("LLNODE_SYMBOL_INDEX");
+  if (enabled != nullptr && strcmp(enabled, "0") == 0) return;
+
+  std::string path = ProfilePath(build_id_);
+  if (!path.empty()) {
+    Error err;
+    if (ReadProfile(path, err)) {
+      PRINT_DEBUG("Loaded constants profile %s", path.c_str());
+      return;
+    }
+  }
+
+  LoadFromSymbols();
+  indexed_ = !values_.empty();
+  dirty_ = indexed_;
+  SaveProfile();
+}
+
+// Only complete indexes are cached, a profile with some of the postmortem
+// symbols would make the others look missing.
+void SymbolIndex::SaveProfile() {
+  if (!dirty_ || !indexed_) return;
+  dirty_ = false;
+
+  std::string path = ProfilePath(build_id_);
+  if (path.empty()) return;
+
+  Error err;
+  if (!ExportProfile(path, err)) {
+    PRINT_DEBUG("Failed to save constants profile: %s", err.GetMessage());
+  }
+}
+
+void SymbolIndex::LoadFromSymbols() {
+  std::vector<PendingSymbol> pending;
+  for (uint32_t i = 0; i < target_.GetNumModules(); i++) {
+    SBModule module = target_.GetModuleAtIndex(i);
+    size_t num_symbols = module.GetNumSymbols();
+
+    for (size_t j = 0; j < num_symbols; j++) {
+      SBSymbol symbol = module.GetSymbolAtIndex(j);
+      const char* name = symbol.GetName();
+      if (name == nullptr || !HasIndexedPrefix(name)) continue;
+
+      SBAddress start = symbol.GetStartAddress();
+      SBAddress end = symbol.GetEndAddress();
+      if (!start.IsValid() || !end.IsValid()) continue;
+
+      PendingSymbol entry = {name, start, i, start.GetFileAddress(),
+                             static_cast<uint32_t>(end.GetOffset() -
+                                                   start.GetOffset())};
+      pending.push_back(entry);
+    }
+  }
+
+  // Postmortem symbols are laid out next to each other, read them in as few
+  // chunks as possible.
+  std::sort(pending.begin(), pending.end(),
+            [](const PendingSymbol& a, const PendingSymbol& b) {
+              if (a.module != b.module) return a.module < b.module;
+              return a.file_address < b.file_address;
+            });
+
+  auto batch_begin = pending.begin();
+  for (auto it = pending.begin(); it != pending.end(); ++it) {
+    uint64_t batch_size = it->file_address + std::min<uint32_t>(it->size, 8) -
+                          batch_begin->file_address;
+    if (batch_size > kMaxBatchSize || it->module != batch_begin->module ||
+        it->start.GetSection().GetFileAddress() !=
+            batch_begin->start.GetSection().GetFileAddress()) {
+      ReadBatch(batch_begin, it);
+      batch_begin = it;
+    }
+  }
+  ReadBatch(batch_begin, pending.end());
+
+  PRINT_DEBUG("Indexed %zu postmortem symbols", values_.size());
+}
+
+void SymbolIndex::ReadBatch(std::vector<PendingSymbol>::iterator begin,
+                            std::vector<PendingSymbol>::iterator end) {
+  if (begin == end) return;
+
+  auto last = end - 1;
+  uint64_t base = begin->file_address;
+  uint64_t length =
+      last->file_address + std::min<uint32_t>(last->size, 8) - base;
+
+  std::vector<uint8_t> data(length);
+  SBError sberr;
+  target_.ReadMemory(begin->start, data.data(), length, sberr);
+
+  for (auto it = begin; it != end; ++it) {
+    int64_t value;
+    uint32_t size = std::min<uint32_t>(it->size, 8);
+
+    if (sberr.Fail()) {
+      // Fall back to reading this symbol on its own.
+      uint8_t tmp[8];
+      SBError symbol_err;
+      target_.ReadMemory(it->start, tmp, size, symbol_err);
+      if (symbol_err.Fail()) continue;
+      if (!DecodeSymbolValue(tmp, it->size, &value)) continue;
+    } else if (!DecodeSymbolValue(&data[it->file_address - base], it->size,
+                                  &value)) {
+      continue;
+    }
+
+    // Keep the first definition, like FindSymbols would.
+    values_.emplace(it->name, value);
+  }
+}
+
 Constant<int64_t> Constants::LookupConstant(SBTarget target, const char* name) {
+  SymbolIndex* index = SymbolIndex::Get(target);
+  Constant<int64_t> constant;
+  if (index->Lookup(name, &constant)) return constant;
+
+  constant = FindConstant(target, name);
+  index->Remember(name, constant);
+  return constant;
+}
+
+// Profiles live in $LLNODE_PROFILE_DIR, or in ~/.llnode/profiles. The latter
+// is only created on demand by export and import, so plain sessions don't
+// write to the home directory.
+std::string SymbolIndex::ProfilePath(const std::string& build_id,
+                                     bool create) {
+  if (build_id.empty()) return std::string();
+
+  const char* dir = getenv("LLNODE_PROFILE_DIR");
+  if (dir != nullptr) return std::string(dir) + "/" + build_id + ".profile";
+
+  const char* home = getenv("HOME");
+  if (home == nullptr) return std::string();
+
+  std::string path = std::string(home) + "/.llnode";
+  if (create) mkdir(path.c_str(), 0755);
+  path += "/profiles";
+  if (create) mkdir(path.c_str(), 0755);
+  return path + "/" + build_id + ".profile";
+}
+
+// Written next to `path` and renamed over it, so other sessions reading (or
+// writing) the same profile never see half of it. The "end" line comes last,
+// profiles without it were cut short.
+bool SymbolIndex::ExportProfile(const std::string& path, Error& err) {
+  std::string tmp_path = path + ".tmp." + std::to_string(getpid());
+  std::ofstream file(tmp_path);
+  if (!file.is_open()) {
+    err = Error::Failure("Can't open '%s' for writing", tmp_path.c_str());
+    return false;
+  }
+
+  file << "# llnode constants profile\n";
+  file << "build-id " << build_id_ << "\n";
+  for (auto& entry : values_) {
+    file << "loaded " << entry.first << " " << entry.second << "\n";
+  }
+  for (auto& name : defaults_) {
+    file << "default " << name << "\n";
+  }
+  if (indexed_) file << "indexed all\n";
+  file << "end\n";
+
+  file.close();
+  if (file.fail()) {
+    remove(tmp_path.c_str());
+    err = Error::Failure("Failed to write '%s'", tmp_path.c_str());
+    return false;
+  }
+  if (rename(tmp_path.c_str(), path.c_str()) != 0) {
+    remove(tmp_path.c_str());
+    err = Error::Failure("Failed to replace '%s'", path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool SymbolIndex::ReadProfile(const std::string& path, Error& err) {
+  std::ifstream file(path);
+  if (!file.is_open()) {
+    err = Error::Failure("Can't open '%s'", path.c_str());
+    return false;
+  }
+
+  std::unordered_map<std::string, int64_t> values;
+  std::unordered_set<std::string> defaults;
+  std::string build_id;
+  bool indexed = false;
+  bool complete = false;
+
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#') continue;
+
+    std::istringstream fields(line);
+    std::string status, name;
+    fields >> status >> name;
+
+    // Nothing may follow the end line.
+    if (complete) {
+      err = Error::Failure("Invalid line after the end of '%s': %s",
+                           path.c_str(), line.c_str());
+      return false;
+    }
+
+    if (status == "end") {
+      complete = true;
+    } else if (status == "build-id") {
+      build_id = name;
+    } else if (status == "indexed") {
+      indexed = name == "all";
+    } else if (status == "loaded") {
+      int64_t value;
+      if (!(fields >> value)) {
+        err = Error::Failure("Invalid value for '%s' in '%s'", name.c_str(),
+                             path.c_str());
+        return false;
+      }
+      values.emplace(name, value);
+    } else if (status == "default") {
+      defaults.insert(name);
+    } else {
+      err = Error::Failure("Invalid line in '%s': %s", path.c_str(),
+                           line.c_str());
+      return false;
+    }
+  }
+
+  if (!complete) {
+    err = Error::Failure("Profile '%s' is incomplete", path.c_str());
+    return false;
+  }
+
+  if (build_id != build_id_) {
+    err = Error::Failure("Profile is for build-id '%s', target is '%s'",
+                         build_id.c_str(), build_id_.c_str());
+    return false;
+  }
+
+  if (values.empty()) {
+    err = Error::Failure("No constants in '%s'", path.c_str());
+    return false;
+  }
+
+  values_.swap(values);
+  defaults_.swap(defaults);
+  indexed_ = indexed;
+  return true;
+}
+
+Constant<int64_t> Constants::FindConstant(SBTarget target, const char* name) {
   int64_t res;
 
   SBSymbolContextList context_list = target.FindSymbols(name);
@@ -2,7 +2,12 @@
 #define SRC_CONSTANTS_H_
 
 #include <lldb/API/LLDB.h>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "src/error.h"
 
@@ -58,6 +63,84 @@ class Constant {
   std::string name_;
 };
 
+// Index of the postmortem symbols (v8dbg_* and nodedbg_*) of a target. The
+// symbol tables are walked only once per target and all values are read in
+// batches, instead of searching every symbol table for each constant (and each
+// of its fallbacks). Setting LLNODE_SYMBOL_INDEX=0 disables the index, every
+// constant is then searched for on its own.
+//
+// The index is cached as a constants profile keyed by the executable's
+// build-id, in $LLNODE_PROFILE_DIR or ~/.llnode/profiles if that directory
+// exists, and reused the next time the same binary is loaded so the symbol
+// tables don't need to be walked again. The profile is updated with the
+// constants looked up by each command, including the ones which were missing
+// and fell back to their defaults.
+class SymbolIndex {
+ public:
+  // Each target has its own index, safe to get from several threads.
+  static SymbolIndex* Get(lldb::SBTarget target);
+  // Use the profile at `path` as the index of a target. Unlike Get(), this
+  // doesn't walk the symbol tables if the target wasn't indexed yet.
+  static SymbolIndex* Import(lldb::SBTarget target, const std::string& path,
+                             Error& err);
+  // Save the constants looked up since the last update to the cached profile.
+  static void Update(lldb::SBTarget target);
+  // Drop the index of a target which won't be used anymore.
+  static void Release(lldb::SBTarget target);
+
+  // Returns true if `name` could be resolved (or is known to be missing)
+  // without searching the symbol tables. Like the other members below, takes
+  // load_mutex_ so commands on other threads can share the index.
+  bool Lookup(const char* name, Constant<int64_t>* constant);
+  void Remember(const char* name, Constant<int64_t> constant);
+
+  inline const std::string& build_id() const { return build_id_; }
+  size_t loaded_count() const;
+  size_t default_count() const;
+
+  // Path of the cached profile, `create` makes the profile directory.
+  static std::string ProfilePath(const std::string& build_id,
+                                 bool create = false);
+  bool Export(const std::string& path, Error& err);
+
+ private:
+  static const uint64_t kMaxBatchSize = 64 * 1024;
+
+  struct PendingSymbol {
+    std::string name;
+    lldb::SBAddress start;
+    uint32_t module;
+    uint64_t file_address;
+    uint32_t size;
+  };
+
+  SymbolIndex() : loaded_(false), indexed_(false), dirty_(false) {}
+
+  static SymbolIndex* Find(lldb::SBTarget target, bool create);
+  void Load();
+  void LoadFromSymbols();
+  void ReadBatch(std::vector<PendingSymbol>::iterator begin,
+                 std::vector<PendingSymbol>::iterator end);
+  // Callers hold load_mutex_.
+  bool ExportProfile(const std::string& path, Error& err);
+  bool ReadProfile(const std::string& path, Error& err);
+  void SaveProfile();
+
+  static std::mutex indexes_mutex_;
+  static std::vector<std::unique_ptr<SymbolIndex>> indexes_;
+
+  mutable std::mutex load_mutex_;
+  bool loaded_;
+  // values_ holds every postmortem symbol, names missing from it don't exist.
+  bool indexed_;
+  // Lookups not saved to the cached profile yet.
+  bool dirty_;
+  lldb::SBTarget target_;
+  std::string build_id_;
+  std::unordered_map<std::string, int64_t> values_;
+  std::unordered_set<std::string> defaults_;
+};
+
 #define CONSTANTS_DEFAULT_METHODS(NAME) \
   inline NAME* operator()() {           \
     if (loaded_) return this;           \
@@ -89,6 +172,9 @@ class Constants {
 
   lldb::SBTarget target_;
   bool loaded_;
+
+ private:
+  static Constant<int64_t> FindConstant(SBTarget target, const char* name);
 };
 
 }  // namespace llnode
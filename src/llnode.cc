@@ -3,15 +3,20 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
 #include <cinttypes>
+#include <iomanip>
+#include <map>
 #include <sstream>
 #include <string>
 
 #include <lldb/API/SBExpressionOptions.h>
 
+#include "src/constants.h"
 #include "src/error.h"
 #include "src/llnode.h"
 #include "src/llscan.h"
+#include "src/llv8-inl.h"
 #include "src/llv8.h"
 #include "src/node-inl.h"
 #include "src/printer.h"
@@ -27,6 +32,7 @@ using lldb::SBDebugger;
 using lldb::SBError;
 using lldb::SBExpressionOptions;
 using lldb::SBFrame;
+using lldb::SBProcess;
 using lldb::SBStream;
 using lldb::SBSymbol;
 using lldb::SBTarget;
@@ -34,73 +40,103 @@ using lldb::SBThread;
 using lldb::SBValue;
 
 
+BacktraceCmd::BacktraceCmd(v8::LLV8* llv8, LLScan* llscan)
+    : decoder_(llv8, llscan->GetCodeMap()) {}
+
 bool BacktraceCmd::DoExecute(SBDebugger d, char** cmd,
                              SBCommandReturnObject& result) {
   SBTarget target = d.GetSelectedTarget();
-  SBThread thread = target.GetProcess().GetSelectedThread();
+  SBProcess process = target.GetProcess();
+  SBThread thread = process.GetSelectedThread();
   if (!thread.IsValid()) {
     result.SetError("No valid process, please start something\n");
     return false;
   }
 
-  errno = 0;
-  int number =
-      (cmd != nullptr && *cmd != nullptr) ? strtol(*cmd, nullptr, 10) : -1;
-  if ((number == 0 && errno == EINVAL) || (number < 0 && number != -1)) {
-    result.SetError("Invalid number of frames");
-    return false;
+  bool all = false;
+  int number = -1;
+  for (char** arg = cmd; arg != nullptr && *arg != nullptr; arg++) {
+    if (strcmp(*arg, "-a") == 0 || strcmp(*arg, "--all") == 0) {
+      all = true;
+      continue;
+    }
+
+    errno = 0;
+    number = strtol(*arg, nullptr, 10);
+    if ((number == 0 && errno == EINVAL) || (number < 0 && number != -1)) {
+      result.SetError("Invalid number of frames");
+      return false;
+    }
   }
 
-  // Load V8 constants from postmortem data
-  llv8_->Load(target);
+  decoder_.Load(target);
+
+  if (!all) {
+    PrintThread(thread, true, number, result);
+    result.SetStatus(eReturnStatusSuccessFinishResult);
+    return true;
+  }
 
+  uint32_t num_threads = process.GetNumThreads();
+  for (uint32_t i = 0; i < num_threads; i++) {
+    SBThread current = process.GetThreadAtIndex(i);
+    PrintThread(current, current == thread, number, result);
+    if (i + 1 < num_threads) result.Printf("\n");
+  }
+
+  result.SetStatus(eReturnStatusSuccessFinishResult);
+  return true;
+}
+
+void BacktraceCmd::PrintThread(SBThread thread, bool selected, int number,
+                               SBCommandReturnObject& result) {
   {
     SBStream desc;
-    if (!thread.GetDescription(desc)) return false;
-    result.Printf(" * %s", desc.GetData());
+    if (!thread.GetDescription(desc)) return;
+    result.Printf(" %c %s", selected ? '*' : ' ', desc.GetData());
   }
 
   SBFrame selected_frame = thread.GetSelectedFrame();
 
   uint32_t num_frames = thread.GetNumFrames();
-  if (number != -1) num_frames = number;
+  if (number != -1) num_frames = std::min<uint32_t>(number, num_frames);
   for (uint32_t i = 0; i < num_frames; i++) {
     SBFrame frame = thread.GetFrameAtIndex(i);
-    const char star = (frame == selected_frame ? '*' : ' ');
+    const char star = (selected && frame == selected_frame ? '*' : ' ');
     const uint64_t pc = frame.GetPC();
 
-    if (v8::JSFrame::MightBeV8Frame(frame)) {
-      Error err;
-      v8::JSFrame v8_frame(llv8_, static_cast<int64_t>(frame.GetFP()));
-      Printer printer(llv8_);
-      std::string res = printer.Stringify(v8_frame, err);
-      if (err.Success()) {
-        result.Printf("  %c frame #%u: 0x%016" PRIx64 " %s\n", star, i, pc,
-                      res.c_str());
-        continue;
-      } else {
-        PRINT_DEBUG("%s", err.GetMessage());
-      }
+    std::string res;
+    FrameDecoder::Kind kind =
+        decoder_.Decode(frame, FrameDecoder::kDetailed, res);
+    if (kind != FrameDecoder::kNativeFrame) {
+      result.Printf("  %c frame #%u: 0x%016" PRIx64 " %s\n", star, i, pc,
+                    res.c_str());
+    } else if (!res.empty()) {
+      // C++ stack frame, as described by lldb.
+      result.Printf("  %c %s", star, res.c_str());
     }
+  }
+}
 
-    // Heuristic: a PC in WX memory is almost certainly a V8 builtin.
-    // TODO(bnoordhuis) Find a way to map the PC to the builtin's name.
-    {
-      lldb::SBMemoryRegionInfo info;
-      if (target.GetProcess().GetMemoryRegionInfo(pc, info).Success() &&
-          info.IsExecutable() && info.IsWritable()) {
-        result.Printf("  %c frame #%u: 0x%016" PRIx64 " <builtin>\n", star, i,
-                      pc);
-        continue;
-      }
-    }
+StackCollapseCmd::StackCollapseCmd(v8::LLV8* llv8, LLScan* llscan)
+    : decoder_(llv8, llscan->GetCodeMap()) {}
 
-    // C++ stack frame.
-    SBStream desc;
-    if (frame.GetDescription(desc))
-      result.Printf("  %c %s", star, desc.GetData());
+bool StackCollapseCmd::DoExecute(SBDebugger d, char** cmd,
+                                 SBCommandReturnObject& result) {
+  SBTarget target = d.GetSelectedTarget();
+  SBProcess process = target.GetProcess();
+  if (!process.GetSelectedThread().IsValid()) {
+    result.SetError("No valid process, please start something\n");
+    return false;
   }
 
+  decoder_.Load(target);
+
+  StackTrie trie;
+  for (uint32_t i = 0; i < process.GetNumThreads(); i++)
+    decoder_.AddThread(process.GetThreadAtIndex(i), trie);
+
+  result.Printf("%s", trie.Fold().c_str());
   result.SetStatus(eReturnStatusSuccessFinishResult);
   return true;
 }
@@ -163,6 +199,62 @@ bool SetTreePaddingCmd::DoExecute(SBDebugger d, char** cmd,
 }
 
 
+bool ConstantsProfileCmd::DoExecute(SBDebugger d, char** cmd,
+                                    SBCommandReturnObject& result) {
+  SBTarget target = d.GetSelectedTarget();
+  if (!target.IsValid()) {
+    result.SetError("No valid process, please start something\n");
+    return false;
+  }
+
+  std::string path;
+  if (cmd != nullptr && *cmd != nullptr) {
+    path = cmd[0];
+  } else if (action_ == kImport) {
+    result.SetError("USAGE: v8 settings constants import file\n");
+    return false;
+  }
+
+  Error err;
+  SymbolIndex* index;
+  if (action_ == kExport) {
+    // Load V8 constants from postmortem data
+    llv8_->Load(target);
+    index = SymbolIndex::Get(target);
+    if (index->build_id().empty()) {
+      result.SetError("Target has no build-id, can't use constants profiles\n");
+      return false;
+    }
+    if (path.empty()) path = SymbolIndex::ProfilePath(index->build_id(), true);
+    index->Export(path, err);
+  } else {
+    // Before anything is loaded, so the symbol tables aren't walked for
+    // nothing.
+    index = SymbolIndex::Import(target, path, err);
+    if (err.Success()) {
+      // Read the constants of the modules loaded so far again.
+      llv8_->Unload();
+      llv8_->Load(target);
+      node_->Unload();
+      node_->Load(target);
+    }
+  }
+  if (err.Fail()) {
+    result.SetError(err.GetMessage());
+    return false;
+  }
+
+  result.Printf("%s %zu loaded and %zu default constants for build-id %s %s "
+                "'%s'\n",
+                action_ == kExport ? "Exported" : "Imported",
+                index->loaded_count(), index->default_count(),
+                index->build_id().c_str(), action_ == kExport ? "to" : "from",
+                path.c_str());
+  result.SetStatus(eReturnStatusSuccessFinishResult);
+  return true;
+}
+
+
 bool PrintCmd::DoExecute(SBDebugger d, char** cmd,
                          SBCommandReturnObject& result) {
   if (cmd == nullptr || *cmd == nullptr) {
@@ -309,36 +401,129 @@ bool WorkqueueCmd::DoExecute(SBDebugger d, char** cmd,
     return false;
   }
 
-  std::string result_message;
+  bool all = false;
+  addr_t env_addr = 0;
+  detailed_ = false;
+  output_limit_ = 0;
+  for (char** arg = cmd; arg != nullptr && *arg != nullptr; arg++) {
+    if (strcmp(*arg, "-a") == 0 || strcmp(*arg, "--all") == 0) {
+      all = true;
+    } else if (strcmp(*arg, "-d") == 0 || strcmp(*arg, "--detailed") == 0) {
+      detailed_ = true;
+    } else if (strcmp(*arg, "-e") == 0 || strcmp(*arg, "--env") == 0) {
+      char* end = nullptr;
+      if (*(arg + 1) != nullptr) env_addr = strtoull(*(++arg), &end, 0);
+      if (env_addr == 0 || end == nullptr || *end != '\0') {
+        result.SetError("Expected an Environment address after --env\n");
+        return false;
+      }
+    } else if (strcmp(*arg, "-n") == 0 ||
+               strcmp(*arg, "--output-limit") == 0) {
+      if (*(arg + 1) != nullptr) output_limit_ = strtol(*(++arg), nullptr, 10);
+      if (output_limit_ <= 0) {
+        result.SetError("Expected a positive number after --output-limit\n");
+        return false;
+      }
+    } else {
+      result.SetError(
+          "USAGE: [-a|--all] [-e|--env address] [-d|--detailed] "
+          "[-n|--output-limit num]\n");
+      return false;
+    }
+  }
+
   Error err;
 
   llv8_->Load(target);
   node_->Load(target);
+  type_names_.clear();
 
-  node::Environment env = node::Environment::GetCurrent(node_, err);
-  if (err.Fail()) {
-    result.SetError(err.GetMessage());
+  std::vector<node::Environment> environments;
+  if (!GetEnvironments(target, all, env_addr, environments, result))
     return false;
+
+  std::string result_message;
+  for (node::Environment& env : environments) {
+    if (all) {
+      char header[64];
+      snprintf(header, sizeof(header), "Environment 0x%016" PRIx64 ":\n",
+               env.raw());
+      result_message += header;
+    }
+
+    result_message += GetResultMessage(&env, err);
+    if (err.Fail()) {
+      result.SetError(err.GetMessage());
+      return false;
+    }
+  }
+
+  result.Printf("%s", result_message.c_str());
+  return true;
+}
+
+bool WorkqueueCmd::GetEnvironments(SBTarget target, bool all, addr_t env_addr,
+                                   std::vector<node::Environment>& environments,
+                                   SBCommandReturnObject& result) {
+  if (env_addr != 0) {
+    node::Environment env(node_, env_addr);
+    if (!env.Check()) {
+      result.SetError("Not a valid Environment\n");
+      return false;
+    }
+    environments.push_back(env);
+    return true;
+  }
+
+  if (all) {
+    // Every isolate's heap is scanned, so this finds the Environments of
+    // worker threads as well.
+    if (!llscan_->ScanHeapForObjects(target, result)) return false;
+
+    environments =
+        node::Environment::FromContexts(node_, *llscan_->GetContexts());
+    if (environments.empty()) {
+      result.SetError("Couldn't find any node Environment\n");
+      return false;
+    }
+    return true;
   }
 
-  result_message = GetResultMessage(&env, err);
+  Error err;
+  node::Environment env = node::Environment::GetCurrent(node_, err);
   if (err.Fail()) {
     result.SetError(err.GetMessage());
     return false;
   }
-
-  result.Printf("%s", result_message.c_str());
+  environments.push_back(env);
   return true;
 }
 
-std::string GetActiveHandlesCmd::GetResultMessage(node::Environment* env,
-                                                  Error& err) {
-  int active_handles = 0;
+std::string WorkqueueCmd::GetTypeName(v8::JSObject object) {
+  Error err;
+  v8::HeapObject map = object.GetMap(err);
+  if (err.Fail()) return "<unknown>";
+
+  // Handles of the same kind share their Map, only name it once.
+  auto it = type_names_.find(map.raw());
+  if (it != type_names_.end()) return it->second;
+
+  std::string name = object.GetTypeName(err);
+  if (err.Fail() || name.empty()) name = "<unknown>";
+  type_names_.emplace(map.raw(), name);
+  return name;
+}
+
+template <typename Queue>
+std::string WorkqueueCmd::DescribeQueue(Queue queue, Error& err) {
+  uint64_t total = 0;
+  uint64_t printed = 0;
+  std::unordered_map<std::string, uint64_t> counts;
   Printer::PrinterOptions printer_options;
   printer_options.detailed = true;
   std::ostringstream result_message;
 
-  for (auto w : env->handle_wrap_queue()) {
+  for (auto w : queue) {
     addr_t persistent = w.Persistent(err);
     if (err.Fail()) break;
     if (persistent == 0) continue;
@@ -347,6 +532,17 @@ std::string GetActiveHandlesCmd::GetResultMessage(node::Environment* env,
     if (err.Fail()) break;
 
     v8::JSObject v8_object(llv8(), raw_object);
+    total++;
+
+    if (!detailed_) {
+      counts[GetTypeName(v8_object)]++;
+      continue;
+    }
+
+    // Keep counting past the limit, the total is still printed.
+    if (output_limit_ > 0 && printed >= static_cast<uint64_t>(output_limit_))
+      continue;
+
     Printer printer(llv8(), printer_options);
     std::string res = printer.Stringify(v8_object, err);
     if (err.Fail()) {
@@ -354,44 +550,130 @@ std::string GetActiveHandlesCmd::GetResultMessage(node::Environment* env,
       break;
     }
 
-    active_handles++;
+    printed++;
     result_message << res.c_str() << std::endl;
   }
 
-  result_message << "Total: " << active_handles << std::endl;
+  if (!detailed_) {
+    std::vector<std::pair<std::string, uint64_t>> sorted(counts.begin(),
+                                                         counts.end());
+    std::sort(sorted.begin(), sorted.end(),
+              [](const std::pair<std::string, uint64_t>& a,
+                 const std::pair<std::string, uint64_t>& b) {
+                if (a.second != b.second) return a.second > b.second;
+                return a.first < b.first;
+              });
+
+    if (!sorted.empty()) result_message << "  Count  Type" << std::endl;
+    for (auto& entry : sorted) {
+      result_message << std::setw(7) << entry.second << "  " << entry.first
+                     << std::endl;
+    }
+  } else if (printed < total) {
+    result_message << "... " << (total - printed) << " more" << std::endl;
+  }
+
+  result_message << "Total: " << total << std::endl;
   return result_message.str();
 }
 
+std::string GetActiveHandlesCmd::GetResultMessage(node::Environment* env,
+                                                  Error& err) {
+  return DescribeQueue(env->handle_wrap_queue(), err);
+}
+
 
 std::string GetActiveRequestsCmd::GetResultMessage(node::Environment* env,
                                                    Error& err) {
-  int active_requests = 0;
-  Printer::PrinterOptions printer_options;
-  printer_options.detailed = true;
-  std::ostringstream result_message;
+  return DescribeQueue(env->req_wrap_queue(), err);
+}
 
-  for (auto w : env->req_wrap_queue()) {
-    addr_t persistent = w.Persistent(err);
-    if (err.Fail()) break;
-    if (persistent == 0) continue;
 
-    addr_t raw_object = w.Object(err);
-    if (err.Fail()) break;
+std::string EventLoopCmd::GetResultMessage(node::Environment* env,
+                                           Error& err) {
+  node::UvLoop loop(node(), env->FindLoop(err));
+  if (err.Fail()) {
+    // The main thread's Environment runs on the default loop.
+    err = Error();
+    loop = node::UvLoop::GetDefault(node(), err);
+    if (err.Fail()) return std::string();
+  }
 
-    v8::JSObject v8_object(llv8(), raw_object);
-    Printer printer(llv8(), printer_options);
-    std::string res = printer.Stringify(v8_object, err);
-    if (err.Fail()) {
-      PRINT_DEBUG("Failed to load object at address %" PRIx64, raw_object);
-      break;
+  uint32_t active_handles = loop.ActiveHandles(err);
+  if (err.Fail()) return std::string();
+
+  std::vector<node::UvHandle> handles = loop.Handles(err);
+  if (err.Fail()) return std::string();
+
+  node::constants::UvHandle* constants = &node()->uv_handle;
+  struct Counts {
+    uint64_t total = 0;
+    uint64_t active = 0;
+    uint64_t ref = 0;
+  };
+  std::map<std::string, Counts> counts;
+  uint64_t keep_alive = 0;
+  uint64_t next_timer = 0;
+  bool has_timer = false;
+
+  std::ostringstream result_message;
+  char line[128];
+  int printed = 0;
+  for (node::UvHandle& handle : handles) {
+    bool active = (handle.flags & constants->kActiveFlag) != 0;
+    bool ref = (handle.flags & constants->kRefFlag) != 0;
+    bool closing = (handle.flags & constants->kClosingFlag) != 0;
+
+    Counts& type_counts = counts[node::UvHandle::TypeName(handle.type)];
+    type_counts.total++;
+    if (active) type_counts.active++;
+    if (ref) type_counts.ref++;
+    // Only active, referenced handles prevent uv_run() from returning.
+    if (active && ref && !closing) keep_alive++;
+
+    if (active && handle.type == constants->kTimerType &&
+        (!has_timer || handle.timeout < next_timer)) {
+      next_timer = handle.timeout;
+      has_timer = true;
     }
 
-    active_requests++;
-    result_message << res.c_str() << std::endl;
+    if (!detailed_ || (output_limit_ > 0 && printed >= output_limit_))
+      continue;
+    printed++;
+
+    snprintf(line, sizeof(line), "  0x%016" PRIx64 " %-10s%s%s%s", handle.raw,
+             node::UvHandle::TypeName(handle.type), active ? " active" : "",
+             ref ? " ref" : "", closing ? " closing" : "");
+    result_message << line;
+    if (handle.fd != -1) result_message << " fd=" << handle.fd;
+    if (handle.type == constants->kTimerType) {
+      result_message << " timeout=" << handle.timeout
+                     << " repeat=" << handle.repeat;
+    }
+    result_message << std::endl;
+  }
+  if (detailed_ && printed < static_cast<int>(handles.size())) {
+    result_message << "  ... " << (handles.size() - printed) << " more"
+                   << std::endl;
   }
 
-  result_message << "Total: " << active_requests << std::endl;
-  return result_message.str();
+  std::ostringstream summary;
+  snprintf(line, sizeof(line), "Loop 0x%016" PRIx64 ": ", loop.raw());
+  summary << line << handles.size() << " handles, " << active_handles
+          << " active, " << keep_alive << " keeping the loop alive"
+          << std::endl;
+  if (has_timer) {
+    summary << "Next timer expires at " << next_timer << " (loop time, ms)"
+            << std::endl;
+  }
+  if (!counts.empty()) summary << "  Count  Active     Ref  Type" << std::endl;
+  for (auto& entry : counts) {
+    summary << std::setw(7) << entry.second.total << std::setw(8)
+            << entry.second.active << std::setw(8) << entry.second.ref << "  "
+            << entry.first << std::endl;
+  }
+
+  return summary.str() + result_message.str();
 }
 
 
@@ -421,15 +703,24 @@ bool PluginInitialize(SBDebugger d) {
   SBCommand v8 = interpreter.AddMultiwordCommand("v8", "Node.js helpers");
 
   v8.AddCommand(
-      "bt", new llnode::BacktraceCmd(&llv8),
+      "bt", new llnode::BacktraceCmd(&llv8, &llscan),
       "Show a backtrace with node.js JavaScript functions and their args. "
       "An optional argument is accepted; if that argument is a number, it "
       "specifies the number of frames to display. Otherwise all frames will "
-      "be dumped.\n\n"
-      "Syntax: v8 bt [number]\n");
-  interpreter.AddCommand("jsstack", new llnode::BacktraceCmd(&llv8),
+      "be dumped. With -a or --all, the stacks of every thread are shown.\n\n"
+      "Syntax: v8 bt [-a|--all] [number]\n");
+  interpreter.AddCommand("jsstack",
+                         new llnode::BacktraceCmd(&llv8, &llscan),
                          "Alias for `v8 bt`");
 
+  v8.AddCommand(
+      "stackcollapse", new llnode::StackCollapseCmd(&llv8, &llscan),
+      "Print the stacks of every thread in the folded format read by "
+      "flamegraph.pl, one line per distinct stack with the number of threads "
+      "running it. Frames are named as in `v8 bt`, without arguments or "
+      "addresses.\n\n"
+      "Syntax: v8 stackcollapse\n");
+
   v8.AddCommand("print", new llnode::PrintCmd(&llv8, false),
                 "Print short description of the JavaScript value.\n\n"
                 "Syntax: v8 print expr\n");
@@ -463,7 +754,11 @@ bool PluginInitialize(SBDebugger d) {
                 "List all object types and instance counts grouped by type "
                 "name and sorted by instance count. Use -d or --detailed to "
                 "get an output grouped by type name, properties, and array "
-                "length, as well as more information regarding each type.\n");
+                "length, as well as more information regarding each type. "
+                "Use -s or --by-site to group objects by their constructor "
+                "and where it is defined (file:line:column). Use "
+                "--histograms to print the distributions of array lengths, "
+                "array capacity over length and string lengths.\n");
 
   SBCommand settingsCmd =
       v8.AddMultiwordCommand("settings", "Interpreter settings");
@@ -476,6 +771,25 @@ bool PluginInitialize(SBDebugger d) {
   setPropertyCmd.AddCommand("tree-padding", new llnode::SetTreePaddingCmd(),
                             "Set tree-padding value");
 
+  SBCommand constantsCmd = settingsCmd.AddMultiwordCommand(
+      "constants", "Constants profile of the current target");
+
+  constantsCmd.AddCommand(
+      "export",
+      new llnode::ConstantsProfileCmd(&llv8, &node,
+                                      llnode::ConstantsProfileCmd::kExport),
+      "Save the constants loaded for the current executable, keyed by its "
+      "build-id, to a profile. Profiles are saved to and loaded from "
+      "$LLNODE_PROFILE_DIR or ~/.llnode/profiles by default.\n\n"
+      "Syntax: v8 settings constants export [file]\n");
+  constantsCmd.AddCommand(
+      "import",
+      new llnode::ConstantsProfileCmd(&llv8, &node,
+                                      llnode::ConstantsProfileCmd::kImport),
+      "Load a constants profile for the current executable and keep it for "
+      "later sessions.\n\n"
+      "Syntax: v8 settings constants import file\n");
+
   interpreter.AddCommand("findjsobjects", new llnode::FindObjectsCmd(&llscan),
                          "Alias for `v8 findjsobjects`");
 
@@ -498,6 +812,36 @@ bool PluginInitialize(SBDebugger d) {
   v8.AddCommand("nodeinfo", new llnode::NodeInfoCmd(&llscan),
                 "Print information about Node.js\n");
 
+  v8.AddCommand(
+      "heapspaces", new llnode::HeapSpacesCmd(&llscan),
+      "Show how the V8 heap is split between new, old, code and "
+      "large-object space. For each space, print the number of pages, "
+      "committed bytes, bytes of objects found by `v8 findjsobjects` and "
+      "bytes on the free lists. One- and two-word fillers left between "
+      "objects are not counted as free.\n");
+
+  v8.AddCommand(
+      "duplicatestrings", new llnode::DuplicateStringsCmd(&llscan),
+      "List the strings with the most bytes spent on identical copies, "
+      "with the address and number of referrers of a few copies.\n\n"
+      "Possible flags (all optional):\n\n"
+      " * -n num, --output-limit num - print the top `num` strings (default "
+      "20)\n"
+      " * -l num, --length num       - print maximum of `num` characters "
+      "from each string\n\n"
+      "Syntax: v8 duplicatestrings [flags]\n");
+
+  v8.AddCommand(
+      "arraybuffers", new llnode::ArrayBuffersCmd(&llscan),
+      "Show the off-heap memory held by ArrayBuffers and their views (such "
+      "as Buffers): total external bytes, the largest ArrayBuffers, backing "
+      "stores shared by several ArrayBuffers and the number of detached "
+      "ArrayBuffers.\n\n"
+      "Possible flags (all optional):\n\n"
+      " * -n num, --output-limit num - print the `num` largest ArrayBuffers "
+      "(default 10)\n\n"
+      "Syntax: v8 arraybuffers [flags]\n");
+
   v8.AddCommand(
       "findrefs", new llnode::FindReferencesCmd(&llscan),
       "Finds all the object properties which meet the search criteria.\n"
@@ -510,17 +854,125 @@ bool PluginInitialize(SBDebugger d) {
       " * -s, --string string  - all properties that refer to the specified "
       "JavaScript string value\n"
       " * -r, --recursive      - walk through references tree recursively\n"
+      " * -d, --depth num      - with -r, stop `num` levels below the search "
+      "value\n"
+      " * -m, --max-nodes num  - with -r, stop after expanding `num` "
+      "referrers\n"
       "\n");
 
+  v8.AddCommand(
+      "collections", new llnode::CollectionsCmd(&llscan),
+      "List the largest Map, Set, WeakMap and WeakSet instances in the heap "
+      "by number of entries, with the bytes of their backing hash tables. "
+      "`v8 inspect` prints the entries of a collection.\n\n"
+      "Possible flags (all optional):\n\n"
+      " * -n num, --output-limit num - print the first `num` collections "
+      "(default 20)\n\n"
+      "Syntax: v8 collections [flags]\n");
+
+  v8.AddCommand(
+      "contexts", new llnode::ContextsCmd(&llscan),
+      "Group the function contexts in the heap by the function which created "
+      "them, to find closures keeping large contexts alive. Prints per "
+      "function the number of contexts, their slots, the bytes of the values "
+      "held in those slots and the largest of them.\n\n"
+      "Possible flags (all optional):\n\n"
+      " * -n num, --top num - print the first `num` functions (default 20)\n\n"
+      "Syntax: v8 contexts [flags]\n");
+
+  v8.AddCommand(
+      "heapdiff", new llnode::HeapDiffCmd(&llscan),
+      "Compare the objects found by findjsobjects in this core with the ones "
+      "in another core of the same program, to find what grew between the "
+      "two. Prints the instance count and size deltas per type and per "
+      "allocation site, largest growth first, with addresses of instances "
+      "which are new in this core.\n\n"
+      "Possible flags (all optional):\n\n"
+      " * -n num, --output-limit num - print the first `num` types and sites "
+      "(default 20)\n\n"
+      "Syntax: v8 heapdiff [flags] other-core other-exe\n");
+
+  v8.AddCommand(
+      "maps", new llnode::MapsCmd(&llscan),
+      "Report hidden class (Map) churn among the objects found by "
+      "findjsobjects: the constructors with the most distinct Maps, the "
+      "objects in dictionary mode with the bytes of their properties "
+      "dictionaries, and the deepest transition trees.\n\n"
+      "Possible flags (all optional):\n\n"
+      " * -n num, --output-limit num - print the first `num` rows of each "
+      "table (default 20)\n\n"
+      "Syntax: v8 maps [flags]\n");
+
+  v8.AddCommand(
+      "promises", new llnode::PromisesCmd(&llscan),
+      "Count the promises in the heap by state and the reactions waiting on "
+      "pending promises by handler function (`await in fn` for suspended "
+      "async functions). Also prints the longest chains of pending promises "
+      "waiting on each other and the rejected promises without a handler.\n\n"
+      "Possible flags (all optional):\n\n"
+      " * -n num, --output-limit num - print the first `num` handlers, chains "
+      "and rejections (default 20)\n\n"
+      "Syntax: v8 promises [flags]\n");
+
+  v8.AddCommand(
+      "retainers", new llnode::RetainersCmd(&llscan),
+      "Print the shortest paths through which the JavaScript object is "
+      "retained, each starting at a root: a native context, a global object, "
+      "a stack slot or an object with no known referrers.\n\n"
+      "Flags:\n\n"
+      " * -n num, --output-limit num - print at most `num` paths (default 5)\n"
+      " * -d num, --depth num        - stop following referrers after `num` "
+      "edges (default 20)\n"
+      " * -t secs, --timeout secs    - stop the search after `secs` seconds "
+      "(default 30)\n\n"
+      "Syntax: v8 retainers [flags] expr\n");
+
   v8.AddCommand("getactivehandles",
-                new llnode::GetActiveHandlesCmd(&llv8, &node),
+                new llnode::GetActiveHandlesCmd(&llv8, &node, &llscan),
                 "Print all pending handles in the queue. Equivalent to running "
-                "process._getActiveHandles() on the living process.\n");
+                "process._getActiveHandles() on the living process.\n\n"
+                "Handles are counted by constructor, by default for the "
+                "Environment of the selected thread.\n"
+                " * -a, --all              - every Environment, including "
+                "those of worker threads\n"
+                " * -e, --env address      - the Environment at address\n"
+                " * -d, --detailed         - print every handle instead\n"
+                " * -n, --output-limit num - print at most num handles with "
+                "-d\n\n"
+                "Syntax: v8 getactivehandles [flags]\n");
 
   v8.AddCommand(
-      "getactiverequests", new llnode::GetActiveRequestsCmd(&llv8, &node),
+      "getactiverequests",
+      new llnode::GetActiveRequestsCmd(&llv8, &node, &llscan),
       "Print all pending requests in the queue. Equivalent to "
-      "running process._getActiveRequests() on the living process.\n");
+      "running process._getActiveRequests() on the living process.\n\n"
+      "Requests are counted by constructor, by default for the Environment "
+      "of the selected thread.\n"
+      " * -a, --all              - every Environment, including those of "
+      "worker threads\n"
+      " * -e, --env address      - the Environment at address\n"
+      " * -d, --detailed         - print every request instead\n"
+      " * -n, --output-limit num - print at most num requests with -d\n\n"
+      "Syntax: v8 getactiverequests [flags]\n");
+
+  v8.AddCommand(
+      "eventloop", new llnode::EventLoopCmd(&llv8, &node, &llscan),
+      "Show the libuv loop of an Environment: handles counted by type, how "
+      "many are active and referenced, how many keep the loop alive and when "
+      "the next libuv timer expires.\n\n"
+      "Accepts the same flags as getactivehandles, -d prints every handle "
+      "with its flags, file descriptor and timer values.\n\n"
+      "Syntax: v8 eventloop [flags]\n");
+
+  v8.AddCommand(
+      "timers", new llnode::TimersCmd(&llscan),
+      "List the pending JavaScript timers (setTimeout and setInterval), "
+      "grouped by duration and sorted by their first expiry, with their "
+      "callbacks.\n\n"
+      "Possible flags (all optional):\n\n"
+      " * -n num, --output-limit num - print the first `num` durations "
+      "(default 10)\n\n"
+      "Syntax: v8 timers [flags]\n");
 
   // Set initial value for color support
   llnode::Settings* settings = llnode::Settings::GetSettings();
@@ -2,26 +2,46 @@
 #define SRC_LLNODE_H_
 
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <lldb/API/LLDB.h>
 
+#include "src/backtrace.h"
 #include "src/llv8.h"
 #include "src/node.h"
 
 namespace llnode {
 
+class LLScan;
+
 class CommandBase : public lldb::SBCommandPluginInterface {};
 
 class BacktraceCmd : public CommandBase {
  public:
-  BacktraceCmd(v8::LLV8* llv8) : llv8_(llv8) {}
+  BacktraceCmd(v8::LLV8* llv8, LLScan* llscan);
   ~BacktraceCmd() override {}
 
   bool DoExecute(lldb::SBDebugger d, char** cmd,
                  lldb::SBCommandReturnObject& result) override;
 
  private:
-  v8::LLV8* llv8_;
+  void PrintThread(lldb::SBThread thread, bool selected, int number,
+                   lldb::SBCommandReturnObject& result);
+
+  FrameDecoder decoder_;
+};
+
+class StackCollapseCmd : public CommandBase {
+ public:
+  StackCollapseCmd(v8::LLV8* llv8, LLScan* llscan);
+  ~StackCollapseCmd() override {}
+
+  bool DoExecute(lldb::SBDebugger d, char** cmd,
+                 lldb::SBCommandReturnObject& result) override;
+
+ private:
+  FrameDecoder decoder_;
 };
 
 class SetPropertyColorCmd : public CommandBase {
@@ -38,6 +58,23 @@ class SetTreePaddingCmd : public CommandBase {
                  lldb::SBCommandReturnObject& result) override;
 };
 
+class ConstantsProfileCmd : public CommandBase {
+ public:
+  enum Action { kExport, kImport };
+
+  ConstantsProfileCmd(v8::LLV8* llv8, node::Node* node, Action action)
+      : llv8_(llv8), node_(node), action_(action) {}
+  ~ConstantsProfileCmd() override {}
+
+  bool DoExecute(lldb::SBDebugger d, char** cmd,
+                 lldb::SBCommandReturnObject& result) override;
+
+ private:
+  v8::LLV8* llv8_;
+  node::Node* node_;
+  Action action_;
+};
+
 class PrintCmd : public CommandBase {
  public:
   PrintCmd(v8::LLV8* llv8, bool detailed) : llv8_(llv8), detailed_(detailed) {}
@@ -66,7 +103,8 @@ class ListCmd : public CommandBase {
 
 class WorkqueueCmd : public CommandBase {
  public:
-  WorkqueueCmd(v8::LLV8* llv8, node::Node* node) : llv8_(llv8), node_(node) {}
+  WorkqueueCmd(v8::LLV8* llv8, node::Node* node, LLScan* llscan)
+      : llv8_(llv8), node_(node), llscan_(llscan) {}
   ~WorkqueueCmd() override {}
 
   inline v8::LLV8* llv8() { return llv8_; };
@@ -79,23 +117,49 @@ class WorkqueueCmd : public CommandBase {
     return std::string();
   };
 
+ protected:
+  // Count the objects of the wraps in queue by constructor, or print them
+  // with -d.
+  template <typename Queue>
+  std::string DescribeQueue(Queue queue, Error& err);
+
+  bool detailed_ = false;
+  int output_limit_ = 0;
+
  private:
+  bool GetEnvironments(lldb::SBTarget target, bool all, addr_t env_addr,
+                       std::vector<node::Environment>& environments,
+                       lldb::SBCommandReturnObject& result);
+  std::string GetTypeName(v8::JSObject object);
+
   v8::LLV8* llv8_;
   node::Node* node_;
+  LLScan* llscan_;
+
+  // Map -> constructor name
+  std::unordered_map<int64_t, std::string> type_names_;
 };
 
 class GetActiveHandlesCmd : public WorkqueueCmd {
  public:
-  GetActiveHandlesCmd(v8::LLV8* llv8, node::Node* node)
-      : WorkqueueCmd(llv8, node) {}
+  GetActiveHandlesCmd(v8::LLV8* llv8, node::Node* node, LLScan* llscan)
+      : WorkqueueCmd(llv8, node, llscan) {}
 
   std::string GetResultMessage(node::Environment* env, Error& err) override;
 };
 
 class GetActiveRequestsCmd : public WorkqueueCmd {
  public:
-  GetActiveRequestsCmd(v8::LLV8* llv8, node::Node* node)
-      : WorkqueueCmd(llv8, node) {}
+  GetActiveRequestsCmd(v8::LLV8* llv8, node::Node* node, LLScan* llscan)
+      : WorkqueueCmd(llv8, node, llscan) {}
+
+  std::string GetResultMessage(node::Environment* env, Error& err) override;
+};
+
+class EventLoopCmd : public WorkqueueCmd {
+ public:
+  EventLoopCmd(v8::LLV8* llv8, node::Node* node, LLScan* llscan)
+      : WorkqueueCmd(llv8, node, llscan) {}
 
   std::string GetResultMessage(node::Environment* env, Error& err) override;
 };
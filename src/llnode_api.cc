@@ -12,9 +12,13 @@
 
 #include <algorithm>
 #include <cstring>
+#include <mutex>
 
+#include "src/backtrace.h"
+#include "src/constants.h"
 #include "src/llnode_api.h"
 #include "src/llscan.h"
+#include "src/llv8-inl.h"
 #include "src/llv8.h"
 #include "src/printer.h"
 
@@ -27,18 +31,22 @@ LLNodeApi::LLNodeApi()
       process(new lldb::SBProcess()),
       llv8(new v8::LLV8()),
       llscan(new LLScan(llv8.get())) {}
-LLNodeApi::~LLNodeApi() = default;
+LLNodeApi::~LLNodeApi() {
+  // Moved from
+  if (debugger == nullptr) return;
+
+  if (initialized_) SymbolIndex::Release(*target);
+  if (debugger->IsValid()) lldb::SBDebugger::Destroy(*debugger);
+}
 LLNodeApi::LLNodeApi(LLNodeApi&&) = default;
 LLNodeApi& LLNodeApi::operator=(LLNodeApi&&) = default;
 
-bool LLNodeApi::debugger_initialized_ = false;
-
 /* Initialize the SB API and load the core dump */
 bool LLNodeApi::Init(const char* filename, const char* executable) {
-  if (!LLNodeApi::debugger_initialized_) {
-    lldb::SBDebugger::Initialize();
-    LLNodeApi::debugger_initialized_ = true;
-  }
+  // The SB API is initialized once per process, whichever instance or thread
+  // gets here first.
+  static std::once_flag debugger_initialized;
+  std::call_once(debugger_initialized, lldb::SBDebugger::Initialize);
 
   if (initialized_) {
     return false;
@@ -133,13 +141,20 @@ std::string LLNodeApi::GetFrame(size_t thread_index, size_t frame_index) {
   return result;
 }
 
-void LLNodeApi::ScanHeap() {
+void LLNodeApi::FoldStacks(StackTrie* trie) {
+  FrameDecoder decoder(llscan->v8(), llscan->GetCodeMap());
+  decoder.Load(*target);
+
+  for (uint32_t i = 0; i < process->GetNumThreads(); i++)
+    decoder.AddThread(process->GetThreadAtIndex(i), *trie);
+}
+
+bool LLNodeApi::ScanHeap(
+    std::function<bool(uint64_t scanned, uint64_t total)> progress) {
   lldb::SBCommandReturnObject result;
   // Initial scan to create the JavaScript object map
-  // TODO: make it possible to create multiple instances
-  // of llscan and llnode
-  if (!llscan->ScanHeapForObjects(*target, result)) {
-    return;
+  if (!llscan->ScanHeapForObjects(*target, result, progress)) {
+    return false;
   }
   object_types.clear();
 
@@ -151,6 +166,7 @@ void LLNodeApi::ScanHeap() {
   // Sort by instance count
   std::sort(object_types.begin(), object_types.end(),
             TypeRecord::CompareInstanceCounts);
+  return true;
 }
 
 uint32_t LLNodeApi::GetTypeCount() { return object_types.size(); }
@@ -183,18 +199,185 @@ std::unordered_set<uint64_t>* LLNodeApi::GetTypeInstances(size_t type_index) {
   return &(object_types[type_index]->GetInstances());
 }
 
+void LLNodeApi::GetHeapSpaces(std::vector<HeapSpaceInfo>& spaces) {
+  HeapSpaceTotals totals[HeapPage::kNumberOfSpaces];
+  llscan->GetHeapSpaceTotals(totals);
+
+  spaces.clear();
+  for (int i = 0; i < HeapPage::kNumberOfSpaces; i++) {
+    HeapSpaceInfo space;
+    space.name = HeapPage::SpaceName(static_cast<HeapPage::Space>(i));
+    space.pages = totals[i].pages;
+    space.committed = totals[i].committed;
+    space.live = totals[i].live;
+    space.free = totals[i].free;
+    spaces.push_back(space);
+  }
+}
+
 std::string LLNodeApi::GetObject(uint64_t address) {
-  v8::Value v8_value(llscan->v8(), address);
+  std::vector<std::string> objects;
+  GetObjects(&address, 1, objects);
+  return objects[0];
+}
+
+void LLNodeApi::GetObjects(const uint64_t* addresses, size_t count,
+                           std::vector<std::string>& objects) {
   Printer::PrinterOptions printer_options;
   printer_options.detailed = true;
   printer_options.length = 16;
   Printer printer(llscan->v8(), printer_options);
 
-  llnode::Error err;
-  std::string result = printer.Stringify(v8_value, err);
-  if (err.Fail()) {
-    return "Failed to get object";
+  objects.reserve(objects.size() + count);
+  for (size_t i = 0; i < count; i++) {
+    v8::Value v8_value(llscan->v8(), addresses[i]);
+    llnode::Error err;
+    std::string result = printer.Stringify(v8_value, err);
+    if (err.Fail()) result = "Failed to get object";
+    objects.push_back(result);
   }
-  return result;
 }
+
+bool LLNodeApi::GetObjectInfo(uint64_t address, ObjectInfo& info) {
+  v8::LLV8* v8 = llscan->v8();
+  info = ObjectInfo();
+  info.address = address;
+
+  v8::Smi smi(v8, address);
+  if (smi.Check()) {
+    info.kind = ObjectInfo::kSmi;
+    info.type = "Smi";
+    info.number = smi.GetValue();
+    return true;
+  }
+
+  Error err;
+  v8::HeapObject heap_object(v8, address);
+  if (!heap_object.Check()) return false;
+
+  v8::HeapObject map_obj = heap_object.GetMap(err);
+  if (err.Fail()) return false;
+  v8::Map map(map_obj);
+  info.map = map.raw();
+
+  int64_t type = map.GetType(err);
+  if (err.Fail()) return false;
+
+  info.type = heap_object.GetTypeName(err);
+  if (err.Fail()) return false;
+  info.kind = ObjectInfo::kOther;
+
+  if (type == v8->types()->kHeapNumberType) {
+    v8::HeapNumber number(heap_object);
+    v8::CheckedType<double> value = number.GetValue(err);
+    if (err.Fail() || !value.Check()) return false;
+    info.kind = ObjectInfo::kHeapNumber;
+    info.number = *value;
+    return true;
+  }
+
+  if (type < v8->types()->kFirstNonstringType) {
+    v8::String str(heap_object);
+    info.kind = ObjectInfo::kString;
+    info.string = str.ToString(err);
+    return err.Success();
+  }
+
+  if (type == v8->types()->kOddballType) {
+    v8::Oddball oddball(heap_object);
+    v8::Smi kind = oddball.Kind(err);
+    if (err.Fail()) return false;
+
+    int64_t kind_val = kind.GetValue();
+    info.kind = ObjectInfo::kOddball;
+    if (kind_val == v8->oddball()->kFalse)
+      info.string = "false";
+    else if (kind_val == v8->oddball()->kTrue)
+      info.string = "true";
+    else if (kind_val == v8->oddball()->kUndefined)
+      info.string = "undefined";
+    else if (kind_val == v8->oddball()->kNull)
+      info.string = "null";
+    else if (kind_val == v8->oddball()->kTheHole)
+      info.string = "hole";
+    else
+      info.string = "unknown";
+    return true;
+  }
+
+  if (!v8::JSObject::IsObjectType(v8, type) &&
+      type != v8->types()->kJSArrayType &&
+      type != v8->types()->kJSFunctionType) {
+    return true;
+  }
+
+  info.kind = ObjectInfo::kObject;
+  v8::JSObject js_object(heap_object);
+
+  for (auto& entry : js_object.Entries(err)) {
+    if (!entry.first.Check()) continue;
+    std::string key = entry.first.ToString(err);
+    if (err.Fail()) return false;
+    info.property_keys.push_back(key);
+    info.property_values.push_back(entry.second.raw());
+  }
+  if (err.Fail()) return false;
+
+  for (auto& field : js_object.DoubleFields(err)) {
+    std::string key = field.first.ToString(err);
+    if (err.Fail()) return false;
+    info.double_keys.push_back(key);
+    info.double_values.push_back(field.second);
+  }
+  if (err.Fail()) return false;
+
+  v8::Map::ElementsStore store = js_object.GetElementsStore(err);
+  if (err.Fail()) return false;
+  if (store == v8::Map::kTaggedElements)
+    info.elements_kind = ObjectInfo::kTaggedElements;
+  else if (store == v8::Map::kDoubleElements)
+    info.elements_kind = ObjectInfo::kDoubleElements;
+  else if (store == v8::Map::kDictionaryElements)
+    info.elements_kind = ObjectInfo::kDictionaryElements;
+
+  if (store == v8::Map::kTaggedElements || store == v8::Map::kDoubleElements) {
+    v8::HeapObject elements_obj = js_object.Elements(err);
+    if (err.Fail()) return false;
+    v8::FixedArray elements(elements_obj);
+    v8::Smi capacity = elements.Length(err);
+    if (err.Fail()) return false;
+
+    // Arrays may have more capacity than elements.
+    int64_t length = capacity.GetValue();
+    if (type == v8->types()->kJSArrayType) {
+      v8::JSArray array(js_object);
+      v8::Smi array_length = array.Length(err);
+      if (err.Fail()) return false;
+      length = std::min(length, array_length.GetValue());
+    }
+
+    if (store == v8::Map::kTaggedElements) {
+      info.elements.reserve(length);
+      for (int64_t i = 0; i < length; i++) {
+        v8::Value element = elements.Get<v8::Value>(i, err);
+        if (err.Fail()) return false;
+        info.elements.push_back(element.raw());
+      }
+    } else {
+      // Unboxed, 8 bytes each even with pointer compression.
+      info.double_elements.reserve(length);
+      int64_t data = elements.LeaData();
+      for (int64_t i = 0; i < length; i++) {
+        double element = v8->LoadDouble(data + i * sizeof(double), err);
+        if (err.Fail()) return false;
+        info.double_elements.push_back(element);
+      }
+    }
+  }
+
+  for (int64_t field : js_object.InternalFields(err))
+    info.internal_fields.push_back(field);
+  return err.Success();
+}
+
 }  // namespace llnode
@@ -3,6 +3,7 @@
 #ifndef SRC_LLNODE_API_H_
 #define SRC_LLNODE_API_H_
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_set>
@@ -18,12 +19,62 @@ class SBProcess;
 namespace llnode {
 
 class LLScan;
+class StackTrie;
 class TypeRecord;
 
 namespace v8 {
 class LLV8;
 }
 
+// A heap value decoded into plain data instead of `v8 inspect` text. Child
+// values are only referenced by their tagged word, so they are decoded on
+// demand by another GetObjectInfo call.
+struct ObjectInfo {
+  enum Kind { kInvalid, kSmi, kHeapNumber, kString, kOddball, kObject, kOther };
+  enum Elements {
+    kOtherElements,
+    kTaggedElements,
+    kDoubleElements,
+    kDictionaryElements
+  };
+
+  Kind kind = kInvalid;
+  uint64_t address = 0;
+  uint64_t map = 0;
+  // Constructor name of objects, V8 type name of anything else
+  std::string type;
+
+  // kSmi and kHeapNumber
+  double number = 0;
+  // String contents, or the name of an Oddball (true, null, hole...)
+  std::string string;
+
+  // kObject only
+  std::vector<std::string> property_keys;
+  std::vector<uint64_t> property_values;
+  // Unboxed (or boxed but mutable) double fields
+  std::vector<std::string> double_keys;
+  std::vector<double> double_values;
+  // Tagged elements, up to the length of arrays. Holes are kept, so indices
+  // match the JS array's. Dictionary elements aren't decoded.
+  Elements elements_kind = kOtherElements;
+  std::vector<uint64_t> elements;
+  // Double elements, holes are NaN
+  std::vector<double> double_elements;
+  std::vector<uint64_t> internal_fields;
+};
+
+// Pages of one V8 heap space found by the scan, see `v8 heapspaces`.
+struct HeapSpaceInfo {
+  std::string name;
+  uint64_t pages = 0;
+  uint64_t committed = 0;
+  uint64_t live = 0;
+  uint64_t free = 0;
+};
+
+// Each instance has its own debugger, target and caches. Different instances
+// can be used from different threads, a single instance from one at a time.
 class LLNodeApi {
  public:
   // TODO(joyeecheung): a status class for inspection error
@@ -45,20 +96,28 @@ class LLNodeApi {
   uint32_t GetFrameCount(size_t thread_index);
   // TODO(joyeecheung): make this a struct
   std::string GetFrame(size_t thread_index, size_t frame_index);
-  void ScanHeap();
+  // Add the stacks of all threads to trie, see `v8 stackcollapse`
+  void FoldStacks(StackTrie* trie);
+  // Returns false if the scan failed or progress cancelled it, progress is
+  // called from the thread running the scan.
+  bool ScanHeap(
+      std::function<bool(uint64_t scanned, uint64_t total)> progress = nullptr);
   // Must be called after ScanHeap;
   uint32_t GetTypeCount();
   std::string GetTypeName(size_t type_index);
   uint32_t GetTypeInstanceCount(size_t type_index);
   uint32_t GetTypeTotalSize(size_t type_index);
   std::unordered_set<uint64_t>* GetTypeInstances(size_t type_index);
-  // TODO(joyeecheung): templatize all the `Inspect` in llv8.h to
-  // return structured data
+  void GetHeapSpaces(std::vector<HeapSpaceInfo>& spaces);
   std::string GetObject(uint64_t address);
+  // Same as GetObject for each address, sharing one Printer.
+  void GetObjects(const uint64_t* addresses, size_t count,
+                  std::vector<std::string>& objects);
+  // Returns false if address isn't a value V8 could have created
+  bool GetObjectInfo(uint64_t address, ObjectInfo& info);
 
  private:
   bool initialized_;
-  static bool debugger_initialized_;
   std::unique_ptr<lldb::SBDebugger> debugger;
   std::unique_ptr<lldb::SBTarget> target;
   std::unique_ptr<lldb::SBProcess> process;
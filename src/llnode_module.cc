@@ -1,14 +1,18 @@
 // Javascript module API for llnode/lldb
 #include <cinttypes>
 #include <cstdlib>
+#include <cstring>
 
+#include "src/backtrace.h"
 #include "src/llnode_api.h"
 #include "src/llnode_module.h"
 
 namespace llnode {
 
 using Napi::Array;
+using Napi::BigUint64Array;
 using Napi::CallbackInfo;
+using Napi::Float64Array;
 using Napi::Function;
 using Napi::FunctionReference;
 using Napi::HandleScope;
@@ -16,9 +20,11 @@ using Napi::Number;
 using Napi::Object;
 using Napi::ObjectReference;
 using Napi::Persistent;
+using Napi::Promise;
 using Napi::Reference;
 using Napi::String;
 using Napi::Symbol;
+using Napi::ThreadSafeFunction;
 using Napi::TypeError;
 using Napi::Value;
 
@@ -38,7 +44,12 @@ Object LLNode::Init(Napi::Env env, Object exports) {
           InstanceMethod("getProcessInfo", &LLNode::GetProcessInfo),
           InstanceMethod("getProcessObject", &LLNode::GetProcessObject),
           InstanceMethod("getHeapTypes", &LLNode::GetHeapTypes),
+          InstanceMethod("getHeapSpaces", &LLNode::GetHeapSpaces),
+          InstanceMethod("scanHeap", &LLNode::ScanHeap),
+          InstanceMethod("cancelScan", &LLNode::CancelScan),
           InstanceMethod("getObjectAtAddress", &LLNode::GetObjectAtAddress),
+          InstanceMethod("getObjects", &LLNode::GetObjects),
+          InstanceMethod("getObjectInfo", &LLNode::GetObjectInfo),
       });
 
   constructor = Persistent(func);
@@ -46,6 +57,8 @@ Object LLNode::Init(Napi::Env env, Object exports) {
 
   exports.Set("fromCoredump",
               Function::New(env, LLNode::FromCoreDump, "fromCoredump"));
+  exports.Set("collapseStacks",
+              Function::New(env, LLNode::CollapseStacks, "collapseStacks"));
 
   exports.Set("LLNode", func);
   return exports;
@@ -54,6 +67,8 @@ Object LLNode::Init(Napi::Env env, Object exports) {
 LLNode::LLNode(const CallbackInfo& args)
     : ObjectWrap<LLNode>(args),
       heap_initialized_(false),
+      scanning_(false),
+      cancel_scan_(false),
       api_(new llnode::LLNodeApi){};
 
 LLNode::~LLNode() {}
@@ -82,6 +97,43 @@ Value LLNode::FromCoreDump(const CallbackInfo& args) {
   return llnode_obj;
 }
 
+// Fold the stacks of every thread of every core into a single folded-stack
+// text, so a batch of cores makes one flamegraph.
+Value LLNode::CollapseStacks(const CallbackInfo& args) {
+  Napi::Env env = args.Env();
+
+  if (!args[0].IsArray() || !args[1].IsString()) {
+    TypeError::New(env,
+                   "Must be called as collapseStacks(filenames, executable)")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  Array filenames = args[0].As<Array>();
+  std::string executable = args[1].As<String>();
+
+  StackTrie trie;
+  for (uint32_t i = 0; i < filenames.Length(); i++) {
+    Napi::Value filename_value = filenames.Get(i);
+    if (!filename_value.IsString()) {
+      TypeError::New(env, "Core dump filenames must be strings")
+          .ThrowAsJavaScriptException();
+      return env.Null();
+    }
+
+    std::string filename = filename_value.As<String>();
+    LLNodeApi api;
+    if (!api.Init(filename.c_str(), executable.c_str())) {
+      TypeError::New(env, "Failed to load coredump " + filename)
+          .ThrowAsJavaScriptException();
+      return env.Null();
+    }
+    api.FoldStacks(&trie);
+  }
+
+  return String::New(env, trie.Fold());
+}
+
 #define CHECK_INITIALIZED(api, env)                        \
   if (!api->IsInitialized()) {                             \
     TypeError::New(env, "LLNode has not been initialized") \
@@ -89,8 +141,17 @@ Value LLNode::FromCoreDump(const CallbackInfo& args) {
     return env.Null();                                     \
   }
 
+// The api can't be used from the JS thread while a scan runs on it.
+#define CHECK_NOT_SCANNING(llnode, env)                                  \
+  if (llnode->scanning_) {                                               \
+    Napi::Error::New(env, "A heap scan is in progress, wait for scanHeap") \
+        .ThrowAsJavaScriptException();                                   \
+    return env.Null();                                                   \
+  }
+
 Value LLNode::GetProcessInfo(const CallbackInfo& args) {
   CHECK_INITIALIZED(this->api_, args.Env())
+  CHECK_NOT_SCANNING(this, args.Env())
 
   return String::New(args.Env(), this->api_->GetProcessInfo());
 }
@@ -98,6 +159,7 @@ Value LLNode::GetProcessInfo(const CallbackInfo& args) {
 Value LLNode::GetProcessObject(const CallbackInfo& args) {
   Napi::Env env = args.Env();
   CHECK_INITIALIZED(this->api_, env)
+  CHECK_NOT_SCANNING(this, env)
 
   uint32_t pid = this->api_->GetProcessID();
   std::string state = this->api_->GetProcessState();
@@ -136,6 +198,7 @@ Value LLNode::GetProcessObject(const CallbackInfo& args) {
 Value LLNode::GetHeapTypes(const CallbackInfo& args) {
   Napi::Env env = args.Env();
   CHECK_INITIALIZED(this->api_, env)
+  CHECK_NOT_SCANNING(this, env)
   Object llnode_obj = args.This().As<Object>();
 
   // Initialize the heap and the type iterators
@@ -144,6 +207,142 @@ Value LLNode::GetHeapTypes(const CallbackInfo& args) {
     this->heap_initialized_ = true;
   }
 
+  return GetHeapTypeList(env, llnode_obj);
+}
+
+Value LLNode::GetHeapSpaces(const CallbackInfo& args) {
+  Napi::Env env = args.Env();
+  CHECK_INITIALIZED(this->api_, env)
+  CHECK_NOT_SCANNING(this, env)
+
+  if (!this->heap_initialized_) {
+    this->api_->ScanHeap();
+    this->heap_initialized_ = true;
+  }
+
+  std::vector<HeapSpaceInfo> spaces;
+  this->api_->GetHeapSpaces(spaces);
+
+  Array space_list = Array::New(env);
+  for (size_t i = 0; i < spaces.size(); i++) {
+    Object space = Object::New(env);
+    space.Set("name", String::New(env, spaces[i].name));
+    space.Set("pages", Number::New(env, spaces[i].pages));
+    space.Set("committed", Number::New(env, spaces[i].committed));
+    space.Set("live", Number::New(env, spaces[i].live));
+    space.Set("free", Number::New(env, spaces[i].free));
+    space_list.Set(i, space);
+  }
+  return space_list;
+}
+
+// Runs the heap scan on a worker thread, so a large core doesn't block the
+// event loop. Progress is posted back through a thread-safe function.
+class ScanHeapWorker : public Napi::AsyncWorker {
+ public:
+  ScanHeapWorker(Napi::Env env, Object llnode_obj, LLNode* llnode)
+      : Napi::AsyncWorker(env, "llnode.scanHeap"),
+        deferred_(Promise::Deferred::New(env)),
+        llnode_obj_(Persistent(llnode_obj)),
+        llnode_(llnode),
+        has_progress_(false),
+        last_percent_(-1) {}
+
+  void SetProgress(Napi::Env env, Function on_progress) {
+    progress_ = ThreadSafeFunction::New(env, on_progress,
+                                        "llnode.scanHeap.progress", 0, 1);
+    has_progress_ = true;
+  }
+
+  Promise GetPromise() { return deferred_.Promise(); }
+
+ protected:
+  void Execute() override {
+    bool ok = llnode_->api_->ScanHeap([this](uint64_t scanned,
+                                             uint64_t total) {
+      if (has_progress_ && total != 0) {
+        // One call per percent, the scan reads a block every megabyte.
+        int percent = static_cast<int>(scanned * 100 / total);
+        if (percent != last_percent_) {
+          last_percent_ = percent;
+          progress_.NonBlockingCall(
+              new std::pair<uint64_t, uint64_t>(scanned, total),
+              [](Napi::Env env, Function callback,
+                 std::pair<uint64_t, uint64_t>* data) {
+                callback.Call({Number::New(env, data->first),
+                               Number::New(env, data->second)});
+                delete data;
+              });
+        }
+      }
+      return !llnode_->cancel_scan_;
+    });
+
+    if (!ok) {
+      SetError(llnode_->cancel_scan_ ? "Heap scan cancelled"
+                                     : "Failed to scan the heap");
+    }
+  }
+
+  void OnOK() override {
+    Finish();
+    llnode_->heap_initialized_ = true;
+    deferred_.Resolve(llnode_->GetHeapTypeList(Env(), llnode_obj_.Value()));
+  }
+
+  void OnError(const Napi::Error& e) override {
+    Finish();
+    deferred_.Reject(e.Value());
+  }
+
+ private:
+  void Finish() {
+    llnode_->scanning_ = false;
+    llnode_->cancel_scan_ = false;
+    if (has_progress_) progress_.Release();
+  }
+
+  Promise::Deferred deferred_;
+  ObjectReference llnode_obj_;
+  LLNode* llnode_;
+  ThreadSafeFunction progress_;
+  bool has_progress_;
+  int last_percent_;
+};
+
+Value LLNode::ScanHeap(const CallbackInfo& args) {
+  Napi::Env env = args.Env();
+  CHECK_INITIALIZED(this->api_, env)
+  CHECK_NOT_SCANNING(this, env)
+
+  if (!args[0].IsUndefined() && !args[0].IsFunction()) {
+    TypeError::New(env, "Must be called as scanHeap([onProgress])")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  Object llnode_obj = args.This().As<Object>();
+  if (this->heap_initialized_) {
+    Promise::Deferred deferred = Promise::Deferred::New(env);
+    deferred.Resolve(GetHeapTypeList(env, llnode_obj));
+    return deferred.Promise();
+  }
+
+  ScanHeapWorker* worker = new ScanHeapWorker(env, llnode_obj, this);
+  if (args[0].IsFunction()) worker->SetProgress(env, args[0].As<Function>());
+  this->scanning_ = true;
+  this->cancel_scan_ = false;
+  worker->Queue();
+  return worker->GetPromise();
+}
+
+Value LLNode::CancelScan(const CallbackInfo& args) {
+  // Checked by the scan after each block, scanHeap's promise then rejects.
+  if (this->scanning_) this->cancel_scan_ = true;
+  return Napi::Boolean::New(args.Env(), this->scanning_);
+}
+
+Array LLNode::GetHeapTypeList(Napi::Env env, Object llnode_obj) {
   uint32_t type_count = this->api_->GetTypeCount();
   Array type_list = Array::New(env);
   for (size_t i = 0; i < type_count; i++) {
@@ -173,6 +372,7 @@ Object LLNode::GetObjectAtAddress(Napi::Env env, uint64_t addr) {
 Value LLNode::GetObjectAtAddress(const CallbackInfo& args) {
   Napi::Env env = args.Env();
   CHECK_INITIALIZED(this->api_, env)
+  CHECK_NOT_SCANNING(this, env)
 
   if (!args[0].IsString()) {
     TypeError::New(env, "First argument must be a string")
@@ -192,12 +392,137 @@ Value LLNode::GetObjectAtAddress(const CallbackInfo& args) {
   return result;
 }
 
+// Decode a batch of objects, given as the BigUint64Array returned by
+// getInstanceAddresses() or a part of it, into an array of their values.
+Value LLNode::GetObjects(const CallbackInfo& args) {
+  Napi::Env env = args.Env();
+  CHECK_INITIALIZED(this->api_, env)
+  CHECK_NOT_SCANNING(this, env)
+
+  if (!args[0].IsTypedArray() ||
+      args[0].As<Napi::TypedArray>().TypedArrayType() !=
+          napi_biguint64_array) {
+    TypeError::New(env, "First argument must be a BigUint64Array")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  BigUint64Array addresses = args[0].As<BigUint64Array>();
+  std::vector<std::string> objects;
+  this->api_->GetObjects(addresses.Data(), addresses.ElementLength(), objects);
+
+  Array result = Array::New(env, objects.size());
+  for (size_t i = 0; i < objects.size(); i++) {
+    result.Set(i, String::New(env, objects[i]));
+  }
+  return result;
+}
+
+static BigUint64Array ToBigUint64Array(Napi::Env env,
+                                     const std::vector<uint64_t>& values) {
+  BigUint64Array result = BigUint64Array::New(env, values.size());
+  if (!values.empty())
+    memcpy(result.Data(), values.data(), values.size() * sizeof(uint64_t));
+  return result;
+}
+
+static Float64Array ToFloat64Array(Napi::Env env,
+                                   const std::vector<double>& values) {
+  Float64Array result = Float64Array::New(env, values.size());
+  if (!values.empty())
+    memcpy(result.Data(), values.data(), values.size() * sizeof(double));
+  return result;
+}
+
+// The structured counterpart of getObjectAtAddress(). Properties, elements
+// and internal fields are tagged values, each one can be passed back to
+// getObjectInfo() to decode it.
+Value LLNode::GetObjectInfo(const CallbackInfo& args) {
+  Napi::Env env = args.Env();
+  CHECK_INITIALIZED(this->api_, env)
+  CHECK_NOT_SCANNING(this, env)
+
+  if (!args[0].IsBigInt()) {
+    TypeError::New(env, "First argument must be a BigInt")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  bool lossless;
+  uint64_t addr = args[0].As<Napi::BigInt>().Uint64Value(&lossless);
+  ObjectInfo info;
+  if (!lossless || !this->api_->GetObjectInfo(addr, info)) {
+    Napi::Error::New(env, "Failed to decode the value at this address")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  static const char* kinds[] = {"invalid", "smi",     "number", "string",
+                                "oddball", "object", "other"};
+  static const char* elements_kinds[] = {"other", "tagged", "double",
+                                         "dictionary"};
+  Object result = Object::New(env);
+  result.Set("address", Napi::BigInt::New(env, info.address));
+  result.Set("kind", String::New(env, kinds[info.kind]));
+  result.Set("type", String::New(env, info.type));
+
+  switch (info.kind) {
+    case ObjectInfo::kSmi:
+      result.Set("value", Number::New(env, info.number));
+      return result;
+    case ObjectInfo::kHeapNumber:
+      result.Set("value", Number::New(env, info.number));
+      break;
+    case ObjectInfo::kString:
+    case ObjectInfo::kOddball:
+      result.Set("value", String::New(env, info.string));
+      break;
+    case ObjectInfo::kObject: {
+      Array keys = Array::New(env, info.property_keys.size());
+      for (size_t i = 0; i < info.property_keys.size(); i++)
+        keys.Set(i, String::New(env, info.property_keys[i]));
+
+      Object properties = Object::New(env);
+      properties.Set("keys", keys);
+      properties.Set("values", ToBigUint64Array(env, info.property_values));
+
+      Array double_keys = Array::New(env, info.double_keys.size());
+      for (size_t i = 0; i < info.double_keys.size(); i++)
+        double_keys.Set(i, String::New(env, info.double_keys[i]));
+      properties.Set("doubleKeys", double_keys);
+      properties.Set("doubleValues", ToFloat64Array(env, info.double_values));
+      result.Set("properties", properties);
+
+      result.Set("elementsKind",
+                 String::New(env, elements_kinds[info.elements_kind]));
+      result.Set("elements", ToBigUint64Array(env, info.elements));
+      if (info.elements_kind == ObjectInfo::kDoubleElements) {
+        result.Set("doubleElements",
+                   ToFloat64Array(env, info.double_elements));
+      }
+      result.Set("internalFields",
+                 ToBigUint64Array(env, info.internal_fields));
+      break;
+    }
+    default:
+      break;
+  }
+
+  result.Set("map", Napi::BigInt::New(env, info.map));
+  return result;
+}
+
 FunctionReference LLNodeHeapType::constructor;
 
 Object LLNodeHeapType::Init(Napi::Env env, Object exports) {
   HandleScope scope(env);
 
-  Function func = DefineClass(env, "LLNodeHeapType", {});
+  Function func = DefineClass(
+      env, "LLNodeHeapType",
+      {
+          InstanceMethod("getInstanceAddresses",
+                         &LLNodeHeapType::GetInstanceAddresses),
+      });
 
   constructor = Persistent(func);
   constructor.SuppressDestruct();
@@ -259,6 +584,7 @@ void LLNodeHeapType::InitInstances() {
       this->llnode()->api_->GetTypeInstances(this->type_index_);
   this->current_instance_index_ = 0;
 
+  this->type_instances_.reserve(instances_set->size());
   for (const uint64_t& addr : *instances_set) {
     this->type_instances_.push_back(addr);
   }
@@ -282,6 +608,12 @@ Value LLNodeHeapType::NextInstance(const CallbackInfo& args) {
 
   LLNodeHeapType* obj =
       ObjectWrap<LLNodeHeapType>::Unwrap(args[0].As<Object>());
+  if (obj->llnode()->scanning_) {
+    Napi::Error::New(env, "A heap scan is in progress, wait for scanHeap")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
   if (!obj->instances_initialized_) {
     obj->InitInstances();
   }
@@ -295,4 +627,27 @@ Value LLNodeHeapType::NextInstance(const CallbackInfo& args) {
   return result;
 }
 
+// The addresses of every instance, without a JS object per instance. The
+// array is copied once into memory owned by V8 and shared by later calls.
+Value LLNodeHeapType::GetInstanceAddresses(const CallbackInfo& args) {
+  Napi::Env env = args.Env();
+  if (this->llnode()->scanning_) {
+    Napi::Error::New(env, "A heap scan is in progress, wait for scanHeap")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  if (!this->instance_addresses_.IsEmpty()) {
+    return this->instance_addresses_.Value();
+  }
+
+  if (!this->instances_initialized_) {
+    this->InitInstances();
+  }
+
+  BigUint64Array addresses = ToBigUint64Array(env, this->type_instances_);
+  this->instance_addresses_ = Persistent(static_cast<Object>(addresses));
+  return addresses;
+}
+
 }  // namespace llnode
@@ -2,15 +2,18 @@
 #define SRC_LLNODE_API_MODULE_H
 
 #include <napi.h>
+#include <atomic>
 #include <memory>
 
 namespace llnode {
 
 class LLNodeApi;
 class LLNodeHeapType;
+class ScanHeapWorker;
 
 class LLNode : public Napi::ObjectWrap<LLNode> {
   friend class LLNodeHeapType;
+  friend class ScanHeapWorker;
 
  public:
   static Napi::Object Init(Napi::Env env, Napi::Object exports);
@@ -22,13 +25,24 @@ class LLNode : public Napi::ObjectWrap<LLNode> {
   LLNode() = delete;
 
   static Napi::Value FromCoreDump(const Napi::CallbackInfo& args);
+  static Napi::Value CollapseStacks(const Napi::CallbackInfo& args);
 
   Napi::Value GetProcessInfo(const Napi::CallbackInfo& args);
   Napi::Value GetProcessObject(const Napi::CallbackInfo& args);
   Napi::Value GetHeapTypes(const Napi::CallbackInfo& args);
+  Napi::Value GetHeapSpaces(const Napi::CallbackInfo& args);
+  Napi::Value ScanHeap(const Napi::CallbackInfo& args);
+  Napi::Value CancelScan(const Napi::CallbackInfo& args);
   Napi::Value GetObjectAtAddress(const Napi::CallbackInfo& args);
+  Napi::Value GetObjects(const Napi::CallbackInfo& args);
+  Napi::Value GetObjectInfo(const Napi::CallbackInfo& args);
+
+  Napi::Array GetHeapTypeList(Napi::Env env, Napi::Object llnode_obj);
 
   bool heap_initialized_;
+  // Set while a ScanHeapWorker owns api_
+  bool scanning_;
+  std::atomic<bool> cancel_scan_;
 
  protected:
   Napi::Object GetObjectAtAddress(Napi::Env env, uint64_t addr);
@@ -44,6 +58,7 @@ class LLNodeHeapType : public Napi::ObjectWrap<LLNodeHeapType> {
   ~LLNodeHeapType();
 
   static Napi::Value NextInstance(const Napi::CallbackInfo& args);
+  Napi::Value GetInstanceAddresses(const Napi::CallbackInfo& args);
 
   static Napi::FunctionReference constructor;
 
@@ -60,6 +75,8 @@ class LLNodeHeapType : public Napi::ObjectWrap<LLNodeHeapType> {
   std::vector<uint64_t> type_instances_;
   bool instances_initialized_;
   size_t current_instance_index_;
+  // Filled by the first getInstanceAddresses() call
+  Napi::ObjectReference instance_addresses_;
 
   std::string type_name_;
   size_t type_index_;
@@ -4,12 +4,15 @@
 #include <string.h>
 
 #include <algorithm>
+#include <chrono>
 #include <cinttypes>
+#include <deque>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <lldb/API/SBExpressionOptions.h>
@@ -29,6 +32,7 @@ using lldb::SBCommandReturnObject;
 using lldb::SBDebugger;
 using lldb::SBError;
 using lldb::SBExpressionOptions;
+using lldb::SBProcess;
 using lldb::SBStream;
 using lldb::SBTarget;
 using lldb::SBValue;
@@ -112,10 +116,14 @@ bool FindObjectsCmd::DoExecute(SBDebugger d, char** cmd,
     return false;
   }
 
-  Printer::PrinterOptions printer_options;
-  ParsePrinterOptions(cmd, &printer_options);
+  Options options;
+  ParseOptions(cmd, &options);
 
-  if (printer_options.detailed) {
+  if (options.histograms) {
+    HistogramsOutput(result);
+  } else if (options.by_site) {
+    SiteOutput(result);
+  } else if (options.detailed) {
     DetailedOutput(result);
   } else {
     SimpleOutput(result);
@@ -126,6 +134,49 @@ bool FindObjectsCmd::DoExecute(SBDebugger d, char** cmd,
 }
 
 
+void FindObjectsCmd::ParseOptions(char** cmd, Options* options) {
+  static struct option opts[] = {{"detailed", no_argument, nullptr, 'd'},
+                                 {"verbose", no_argument, nullptr, 'v'},
+                                 {"by-site", no_argument, nullptr, 's'},
+                                 {"histograms", no_argument, nullptr, 'H'},
+                                 {nullptr, 0, nullptr, 0}};
+
+  int argc = 1;
+  for (char** p = cmd; p != nullptr && *p != nullptr; p++) argc++;
+
+  char* args[argc];
+
+  // Make this look like a command line, we need a valid element at index 0
+  // for getopt_long to use in its error messages.
+  char name[] = "llnode";
+  args[0] = name;
+  for (int i = 0; i < argc - 1; i++) args[i + 1] = cmd[i];
+
+  // Reset getopts.
+  optind = 0;
+  opterr = 1;
+  do {
+    int arg = getopt_long(argc, args, "dvsH", opts, nullptr);
+    if (arg == -1) break;
+
+    switch (arg) {
+      case 'd':
+      case 'v':
+        options->detailed = true;
+        break;
+      case 's':
+        options->by_site = true;
+        break;
+      case 'H':
+        options->histograms = true;
+        break;
+      default:
+        continue;
+    }
+  } while (true);
+}
+
+
 void FindObjectsCmd::SimpleOutput(SBCommandReturnObject& result) {
   /* Create a vector to hold the entries sorted by instance count
    * TODO(hhellyer) - Make sort type an option (by count, size or name)
@@ -193,6 +244,44 @@ void FindObjectsCmd::DetailedOutput(SBCommandReturnObject& result) {
 }
 
 
+void FindObjectsCmd::SiteOutput(SBCommandReturnObject& result) {
+  std::vector<TypeRecord*> sorted_by_count;
+  for (auto kv : llscan_->GetSitesToInstances()) {
+    sorted_by_count.push_back(kv.second);
+  }
+
+  std::sort(sorted_by_count.begin(), sorted_by_count.end(),
+            TypeRecord::CompareInstanceCounts);
+
+  uint64_t total_objects = 0;
+  uint64_t total_size = 0;
+
+  result.Printf(" Instances  Total Size Site\n");
+  result.Printf(" ---------- ---------- ----\n");
+
+  for (auto t : sorted_by_count) {
+    result.Printf(" %10" PRId64 " %10" PRId64 " %s\n", t->GetInstanceCount(),
+                  t->GetTotalInstanceSize(), t->GetTypeName().c_str());
+    total_objects += t->GetInstanceCount();
+    total_size += t->GetTotalInstanceSize();
+  }
+
+  result.Printf(" ---------- ---------- \n");
+  result.Printf(" %10" PRId64 " %10" PRId64 " \n", total_objects, total_size);
+}
+
+
+void FindObjectsCmd::HistogramsOutput(SBCommandReturnObject& result) {
+  const ScanHistograms& histograms = llscan_->GetHistograms();
+  histograms.array_lengths.Print(result, "Array lengths", "Store bytes");
+  result.Printf("\n");
+  histograms.array_slack.Print(result, "Array capacity - length",
+                               "Wasted bytes");
+  result.Printf("\n");
+  histograms.string_lengths.Print(result, "String lengths", "Characters");
+}
+
+
 bool FindInstancesCmd::DoExecute(SBDebugger d, char** cmd,
                                  SBCommandReturnObject& result) {
   if (cmd == nullptr || *cmd == nullptr) {
@@ -469,6 +558,69 @@ bool NodeInfoCmd::DoExecute(SBDebugger d, char** cmd,
   return true;
 }
 
+
+bool HeapSpacesCmd::DoExecute(SBDebugger d, char** cmd,
+                              SBCommandReturnObject& result) {
+  SBTarget target = d.GetSelectedTarget();
+  if (!target.IsValid()) {
+    result.SetError("No valid process, please start something\n");
+    return false;
+  }
+
+  // Load V8 constants from postmortem data
+  llscan_->v8()->Load(target);
+
+  /* Ensure we have a map of objects and pages. */
+  if (!llscan_->ScanHeapForObjects(target, result)) {
+    result.SetStatus(eReturnStatusFailed);
+    return false;
+  }
+
+  HeapSpaceTotals spaces[HeapPage::kNumberOfSpaces];
+  llscan_->GetHeapSpaceTotals(spaces);
+
+  uint64_t total_pages = 0;
+  uint64_t total_committed = 0;
+  uint64_t total_live = 0;
+  uint64_t total_free = 0;
+
+  result.Printf(
+      " Space        Pages    Committed         Live         Free   Free%%\n");
+  result.Printf(
+      " ------------ ------ ------------ ------------ ------------ -------\n");
+
+  for (int i = 0; i < HeapPage::kNumberOfSpaces; i++) {
+    HeapPage::Space space = static_cast<HeapPage::Space>(i);
+    const HeapSpaceTotals& totals = spaces[i];
+    double free_ratio =
+        totals.committed ? 100.0 * totals.free / totals.committed : 0.0;
+    result.Printf(" %-12s %6" PRId64 " %12" PRId64 " %12" PRId64 " %12" PRId64
+                  " %6.1f%%\n",
+                  HeapPage::SpaceName(space), totals.pages, totals.committed,
+                  totals.live, totals.free, free_ratio);
+    total_pages += totals.pages;
+    total_committed += totals.committed;
+    total_live += totals.live;
+    total_free += totals.free;
+  }
+
+  double total_free_ratio =
+      total_committed ? 100.0 * total_free / total_committed : 0.0;
+  result.Printf(
+      " ------------ ------ ------------ ------------ ------------ -------\n");
+  result.Printf(" %-12s %6" PRId64 " %12" PRId64 " %12" PRId64 " %12" PRId64
+                " %6.1f%%\n",
+                "total", total_pages, total_committed, total_live, total_free,
+                total_free_ratio);
+
+  if (total_pages == 0) {
+    result.Printf("No V8 heap pages found.\n");
+  }
+
+  result.SetStatus(eReturnStatusSuccessFinishResult);
+  return true;
+}
+
 bool FindReferencesCmd::DoExecute(SBDebugger d, char** cmd,
                                   SBCommandReturnObject& result) {
   if (cmd == nullptr || *cmd == nullptr) {
@@ -579,7 +731,7 @@ bool FindReferencesCmd::DoExecute(SBDebugger d, char** cmd,
 
   // Store already visited references to avoid and infinite recursive loop
   // when `--recursive (-r)` option is set
-  ReferencesVector already_visited_references;
+  ReferencesSet already_visited_references;
 
   // Get the list of references for the given search value, property or string
   ReferencesVector* references = scanner->GetReferences();
@@ -634,7 +786,7 @@ void FindReferencesCmd::ScanForReferences(ObjectScanner* scanner) {
 
 void FindReferencesCmd::PrintRecursiveReferences(
     lldb::SBCommandReturnObject& result, ScanOptions* options,
-    ReferencesVector* visited_references, uint64_t address, int level) {
+    ReferencesSet* visited_references, uint64_t address, int level) {
   Settings* settings = Settings::GetSettings();
   unsigned int padding = settings->GetTreePadding();
 
@@ -642,14 +794,22 @@ void FindReferencesCmd::PrintRecursiveReferences(
 
   result.Printf("%s", branch.c_str());
 
-  if (find(visited_references->begin(), visited_references->end(), address) !=
-      visited_references->end()) {
-    std::stringstream seen_str;
-    seen_str << rang::fg::red << " [seen above]" << rang::fg::reset
-             << std::endl;
-    result.Printf("%s", seen_str.str().c_str());
+  const char* stop = nullptr;
+  if (visited_references->count(address)) {
+    stop = " [seen above]";
+  } else if (options->max_depth > 0 && level >= options->max_depth) {
+    stop = " [depth limit]";
+  } else if (options->max_nodes > 0 &&
+             visited_references->size() >= options->max_nodes) {
+    stop = " [node limit]";
+  }
+
+  if (stop != nullptr) {
+    std::stringstream stop_str;
+    stop_str << rang::fg::red << stop << rang::fg::reset << std::endl;
+    result.Printf("%s", stop_str.str().c_str());
   } else {
-    visited_references->push_back(address);
+    visited_references->insert(address);
     v8::Value value(llscan_->v8(), address);
     ReferenceScanner scanner_(llscan_, value);
     ReferencesVector* references_ = scanner_.GetReferences();
@@ -661,7 +821,7 @@ void FindReferencesCmd::PrintRecursiveReferences(
 void FindReferencesCmd::PrintReferences(
     SBCommandReturnObject& result, ReferencesVector* references,
     ObjectScanner* scanner, ScanOptions* options,
-    ReferencesVector* already_visited_references, int level) {
+    ReferencesSet* already_visited_references, int level) {
   // Walk all the object instances and handle them according to their type.
   TypeRecordMap mapstoinstances = llscan_->GetMapsToInstances();
 
@@ -714,11 +874,14 @@ void FindReferencesCmd::PrintReferences(
 
 
 char** FindReferencesCmd::ParseScanOptions(char** cmd, ScanOptions* options) {
-  static struct option opts[] = {{"value", no_argument, nullptr, 'v'},
-                                 {"name", no_argument, nullptr, 'n'},
-                                 {"string", no_argument, nullptr, 's'},
-                                 {"recursive", no_argument, nullptr, 'r'},
-                                 {nullptr, 0, nullptr, 0}};
+  static struct option opts[] = {
+      {"value", no_argument, nullptr, 'v'},
+      {"name", no_argument, nullptr, 'n'},
+      {"string", no_argument, nullptr, 's'},
+      {"recursive", no_argument, nullptr, 'r'},
+      {"depth", required_argument, nullptr, 'd'},
+      {"max-nodes", required_argument, nullptr, 'm'},
+      {nullptr, 0, nullptr, 0}};
 
   int argc = 1;
   for (char** p = cmd; p != nullptr && *p != nullptr; p++) argc++;
@@ -737,9 +900,21 @@ char** FindReferencesCmd::ParseScanOptions(char** cmd, ScanOptions* options) {
   optind = 0;
   opterr = 1;
   do {
-    int arg = getopt_long(argc, args, "vnsr", opts, nullptr);
+    int arg = getopt_long(argc, args, "vnsrd:m:", opts, nullptr);
     if (arg == -1) break;
 
+    // Limits can be given anywhere, they imply --recursive.
+    if (arg == 'd' || arg == 'm') {
+      int64_t limit = strtoll(optarg, nullptr, 10);
+      if (limit < 0) limit = 0;
+      if (arg == 'd')
+        options->max_depth = static_cast<int>(limit);
+      else
+        options->max_nodes = static_cast<uint64_t>(limit);
+      options->recursive_scan = true;
+      continue;
+    }
+
     if (found_scan_type) {
       options->scan_type = ScanOptions::ScanType::kBadOption;
       break;
@@ -777,9 +952,10 @@ char** FindReferencesCmd::ParseScanOptions(char** cmd, ScanOptions* options) {
 // it is allocated in a Context object.
 void FindReferencesCmd::ReferenceScanner::PrintContextRefs(
     SBCommandReturnObject& result, Error& err, FindReferencesCmd* cli_cmd_,
-    ScanOptions* options, ReferencesVector* already_visited_references,
+    ScanOptions* options, ReferencesSet* already_visited_references,
     int level) {
-  ContextVector* contexts = llscan_->GetContexts();
+  // Only the contexts holding search_value_, found once for all the values.
+  ReferencesVector* contexts = llscan_->GetContextsByValue(search_value_.raw());
   v8::LLV8* v8 = llscan_->v8();
 
   for (auto ctx : *contexts) {
@@ -1380,152 +1556,2199 @@ ReferencesVector* FindReferencesCmd::StringScanner::GetReferences() {
 }
 
 
-FindJSObjectsVisitor::FindJSObjectsVisitor(SBTarget& target, LLScan* llscan)
-    : target_(target), llscan_(llscan) {
-  found_count_ = 0;
-  address_byte_size_ = target_.GetProcess().GetAddressByteSize();
-}
+bool RetainersCmd::DoExecute(SBDebugger d, char** cmd,
+                             SBCommandReturnObject& result) {
+  int count = kDefaultPathCount;
+  int depth = kDefaultDepth;
+  int timeout = kDefaultTimeout;
+  char** start = ParseOptions(cmd, &count, &depth, &timeout);
 
+  if (start == nullptr || *start == nullptr) {
+    result.SetError("USAGE: v8 retainers [flags] expr\n");
+    return false;
+  }
 
-/* Visit every address, a bit brute force but it works. */
-uint64_t FindJSObjectsVisitor::Visit(uint64_t location, uint64_t word) {
-  v8::Value v8_value(llscan_->v8(), word);
+  SBTarget target = d.GetSelectedTarget();
+  if (!target.IsValid()) {
+    result.SetError("No valid process, please start something\n");
+    return false;
+  }
 
-  Error err;
-  // Test if this is SMI
-  // Skip inspecting things that look like Smi's, they aren't objects.
-  v8::Smi smi(v8_value);
-  if (smi.Check()) return address_byte_size_;
+  // Load V8 constants from postmortem data
+  llscan_->v8()->Load(target);
 
-  v8::HeapObject heap_object(v8_value);
-  if (!heap_object.Check()) return address_byte_size_;
+  std::string full_cmd;
+  for (; *start != nullptr; start++) full_cmd += *start;
 
-  v8::HeapObject map_object = heap_object.GetMap(err);
-  if (err.Fail() || !map_object.Check()) return address_byte_size_;
+  SBExpressionOptions options;
+  SBValue value = target.EvaluateExpression(full_cmd.c_str(), options);
+  if (value.GetError().Fail()) {
+    SBError error = value.GetError();
+    result.SetError(error);
+    return false;
+  }
 
-  v8::Map map(map_object);
+  v8::Value search_value(llscan_->v8(), value.GetValueAsSigned());
+  v8::HeapObject search_obj(search_value);
+  if (!search_obj.Check()) {
+    result.SetError("Search value is not a heap object.\n");
+    return false;
+  }
 
-  MapCacheEntry map_info;
-  if (map_cache_.count(map.raw()) == 0) {
-    map_info.Load(map, heap_object, llscan_->v8(), err);
-    if (err.Fail()) {
-      return address_byte_size_;
-    }
-    // Cache result
-    map_cache_.emplace(map.raw(), map_info);
-  } else {
-    map_info = map_cache_.at(map.raw());
+  /* Ensure we have a map of objects. */
+  if (!llscan_->ScanHeapForObjects(target, result)) {
+    result.SetStatus(eReturnStatusFailed);
+    return false;
   }
 
-  if (map_info.is_context) {
-    InsertOnContexts(word, err);
-    return address_byte_size_;
+  // The reverse reference graph, shared with findrefs.
+  FindReferencesCmd::ReferenceScanner scanner(llscan_, v8::Value());
+  if (!scanner.AreReferencesLoaded()) {
+    FindReferencesCmd(llscan_).ScanForReferences(&scanner);
   }
+  LoadReferrers();
+  LoadStackSlots(target.GetProcess());
+
+  // Breadth first from the target towards the roots, so the first path found
+  // to each root is a shortest one. next[holder] is the object holder
+  // retains on the path.
+  std::unordered_map<uint64_t, uint64_t> next;
+  std::vector<std::pair<uint64_t, std::string>> roots;
+  std::deque<std::pair<uint64_t, int>> queue;
+  uint64_t target_addr = search_value.raw();
+  next[target_addr] = 0;
+  queue.emplace_back(target_addr, 0);
+
+  auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(timeout);
+  bool truncated = false;
+  uint64_t visited = 0;
+
+  while (!queue.empty() && roots.size() < static_cast<size_t>(count)) {
+    if (++visited % 1024 == 0 && std::chrono::steady_clock::now() > deadline) {
+      truncated = true;
+      break;
+    }
 
-  if (!map_info.is_histogram) return address_byte_size_;
+    uint64_t addr = queue.front().first;
+    int level = queue.front().second;
+    queue.pop_front();
 
-  InsertOnMapsToInstances(word, map, map_info, err);
-  InsertOnDetailedMapsToInstances(word, map, map_info, err);
+    std::string root = RootName(addr);
+    if (!root.empty()) {
+      roots.emplace_back(addr, root);
+      continue;
+    }
 
-  if (err.Fail()) {
-    return address_byte_size_;
+    ReferencesVector* heap_referrers = llscan_->GetReferencesByValue(addr);
+    ReferencesVector* contexts = llscan_->GetContextsByValue(addr);
+    ReferrerMap::iterator other_referrers = referrers_.find(addr);
+    if (heap_referrers->empty() && contexts->empty() &&
+        other_referrers == referrers_.end()) {
+      // Held by a handle, or by something the scan doesn't decode.
+      roots.emplace_back(addr, "no known referrers");
+      continue;
+    }
+
+    if (level >= depth) {
+      truncated = true;
+      continue;
+    }
+
+    auto visit = [&](uint64_t holder) {
+      if (next.emplace(holder, addr).second)
+        queue.emplace_back(holder, level + 1);
+    };
+    for (uint64_t holder : *heap_referrers) visit(holder);
+    for (uint64_t holder : *contexts) visit(holder);
+    if (other_referrers != referrers_.end())
+      for (uint64_t holder : other_referrers->second) visit(holder);
   }
 
-  found_count_++;
+  result.Printf("%zu retaining path%s for 0x%" PRIx64 " (%" PRIu64
+                " objects visited%s)\n",
+                roots.size(), roots.size() == 1 ? "" : "s", target_addr,
+                visited, truncated ? ", search truncated" : "");
 
-  /* Just advance one word.
-   * (Should advance by object size, assuming objects can't overlap!)
-   */
-  return address_byte_size_;
-}
+  int index = 0;
+  for (auto& root : roots) {
+    std::vector<uint64_t> path;
+    for (uint64_t addr = root.first; addr != 0; addr = next[addr])
+      path.push_back(addr);
 
-void FindJSObjectsVisitor::InsertOnContexts(uint64_t word, Error& err) {
-  ContextVector* contexts;
-  contexts = llscan_->GetContexts();
-  contexts->insert(word);
+    result.Printf("\n #%d %s, %zu edge%s\n", ++index, root.second.c_str(),
+                  path.size() - 1, path.size() == 2 ? "" : "s");
+    for (size_t i = 0; i + 1 < path.size(); i++) {
+      Error err;
+      v8::HeapObject holder(llscan_->v8(), path[i]);
+      std::string type_name = holder.GetTypeName(err);
+      std::string edge = EdgeName(path[i], path[i + 1]);
+      result.Printf("  0x%" PRIx64 ": %s%s=0x%" PRIx64 "\n", path[i],
+                    type_name.c_str(), edge.c_str(), path[i + 1]);
+    }
+  }
+
+  result.SetStatus(eReturnStatusSuccessFinishResult);
+  return true;
 }
 
-void FindJSObjectsVisitor::InsertOnMapsToInstances(
-    uint64_t word, v8::Map map, FindJSObjectsVisitor::MapCacheEntry map_info,
-    Error& err) {
-  TypeRecord* t;
 
-  auto entry = std::make_pair(map_info.type_name, nullptr);
-  auto pp = &llscan_->GetMapsToInstances().insert(entry).first->second;
-  // No entry in the map, create a new one.
-  if (*pp == nullptr) *pp = new TypeRecord(map_info.type_name);
-  t = *pp;
-  t->AddInstance(word, map.InstanceSize(err));
-}
+char** RetainersCmd::ParseOptions(char** cmd, int* count, int* depth,
+                                  int* timeout) {
+  static struct option opts[] = {
+      {"output-limit", required_argument, nullptr, 'n'},
+      {"depth", required_argument, nullptr, 'd'},
+      {"timeout", required_argument, nullptr, 't'},
+      {nullptr, 0, nullptr, 0}};
 
-void FindJSObjectsVisitor::InsertOnDetailedMapsToInstances(
-    uint64_t word, v8::Map map, FindJSObjectsVisitor::MapCacheEntry map_info,
-    Error& err) {
-  DetailedTypeRecord* t;
+  int argc = 1;
+  for (char** p = cmd; p != nullptr && *p != nullptr; p++) argc++;
 
-  auto type_name_with_properties = map_info.GetTypeNameWithProperties();
+  char* args[argc];
 
-  auto entry = std::make_pair(type_name_with_properties, nullptr);
-  auto pp = &llscan_->GetDetailedMapsToInstances().insert(entry).first->second;
-  // No entry in the map, create a new one.
-  if (*pp == nullptr) {
-    auto type_name_with_three_properties = map_info.GetTypeNameWithProperties(
-        MapCacheEntry::kDontShowArrayLength,
-        kNumberOfPropertiesForDetailedOutput);
-    *pp = new DetailedTypeRecord(type_name_with_three_properties,
-                                 map_info.own_descriptors_count_,
-                                 map_info.indexed_properties_count_);
-  }
-  t = *pp;
-  t->AddInstance(word, map.InstanceSize(err));
-}
+  // Make this look like a command line, we need a valid element at index 0
+  // for getopt_long to use in its error messages.
+  char name[] = "llnode";
+  args[0] = name;
+  for (int i = 0; i < argc - 1; i++) args[i + 1] = cmd[i];
 
+  // Reset getopts.
+  optind = 0;
+  opterr = 1;
+  do {
+    int arg = getopt_long(argc, args, "n:d:t:", opts, nullptr);
+    if (arg == -1) break;
 
-bool FindJSObjectsVisitor::IsAHistogramType(v8::Map& map, Error& err) {
-  int64_t type = map.GetType(err);
-  if (err.Fail()) return false;
+    int number = strtol(optarg, nullptr, 10);
+    if (number <= 0) continue;
+    switch (arg) {
+      case 'n':
+        *count = number;
+        break;
+      case 'd':
+        *depth = number;
+        break;
+      case 't':
+        *timeout = number;
+        break;
+      default:
+        continue;
+    }
+  } while (true);
 
-  v8::LLV8* v8 = map.v8();
-  if (v8::JSObject::IsObjectType(v8, type)) return true;
-  if (type == v8->types()->kJSArrayType) return true;
-  if (type == v8->types()->kJSTypedArrayType) return true;
-  if (type < v8->types()->kFirstNonstringType) return true;
-  return false;
+  return &cmd[optind - 1];
 }
 
 
-bool LLScan::ScanHeapForObjects(lldb::SBTarget target,
-                                lldb::SBCommandReturnObject& result) {
-  /* Check the last scan is still valid - the process hasn't moved
-   * and we haven't changed target.
-   */
+void RetainersCmd::LoadReferrers() {
+  v8::LLV8* v8 = llscan_->v8();
+  referrers_.clear();
 
-  // Reload process anyway
-  process_ = target.GetProcess();
+  for (uint64_t ctx : *llscan_->GetContexts()) {
+    Error err;
+    v8::Context c(v8, ctx);
 
-  // Need to reload memory regions.
-  if (target_ != target) {
-    ClearMapsToInstances();
-    ClearReferences();
-    target_ = target;
+    // Locals are found through LLScan::GetContextsByValue().
+    v8::Value previous = c.Previous(err);
+    if (err.Success() && v8::HeapObject(previous).Check())
+      referrers_[previous.raw()].push_back(ctx);
   }
 
-  /* If we've reached here we have access to information about the valid memory
-   * regions in the process and can scan for objects.
-   */
-
-  /* Populate the map of objects. */
-  if (mapstoinstances_.empty()) {
-    FindJSObjectsVisitor v(target, this);
-
-    ScanMemoryRegions(v);
+  for (uint64_t fn : *llscan_->GetFunctions()) {
+    Error err;
+    v8::JSFunction js_fn(v8, fn);
+    v8::HeapObject context = js_fn.GetContext(err);
+    if (err.Success() && context.Check())
+      referrers_[context.raw()].push_back(fn);
   }
 
-  return true;
+  for (uint64_t global : *llscan_->GetGlobalObjects()) {
+    Error err;
+    v8::JSObject js_obj(v8, global);
+    std::set<uint64_t> already_saved;
+    for (auto entry : js_obj.Entries(err)) {
+      uint64_t property = entry.second.raw();
+      if (!already_saved.insert(property).second) continue;
+      referrers_[property].push_back(global);
+    }
+  }
+}
+
+
+void RetainersCmd::LoadStackSlots(lldb::SBProcess process) {
+  stack_slots_.clear();
+
+  uint32_t pointer_size = process.GetAddressByteSize();
+  std::vector<char> stack;
+  for (uint32_t i = 0; i < process.GetNumThreads(); i++) {
+    lldb::SBThread thread = process.GetThreadAtIndex(i);
+    uint64_t sp = thread.GetFrameAtIndex(0).GetSP();
+
+    lldb::SBMemoryRegionInfo info;
+    if (sp == 0 || process.GetMemoryRegionInfo(sp, info).Fail()) continue;
+
+    // Stacks grow down, everything live is between sp and the region end.
+    uint64_t size = std::min<uint64_t>(info.GetRegionEnd() - sp, kMaxStackSize);
+    stack.resize(size);
+    SBError sberr;
+    size = process.ReadMemory(sp, stack.data(), size, sberr);
+
+    for (uint64_t off = 0; off + pointer_size <= size; off += pointer_size) {
+      uint64_t word = 0;
+      memcpy(&word, stack.data() + off, pointer_size);
+      if (!v8::HeapObject(llscan_->v8(), word).Check()) continue;
+      stack_slots_.emplace(word, StackSlot{sp + off, thread.GetIndexID()});
+    }
+  }
+}
+
+
+std::string RetainersCmd::RootName(uint64_t address) {
+  char buf[128];
+
+  auto slot = stack_slots_.find(address);
+  if (slot != stack_slots_.end()) {
+    snprintf(buf, sizeof(buf), "stack slot 0x%" PRIx64 " of thread #%u",
+             slot->second.address, slot->second.thread);
+    return buf;
+  }
+
+  if (llscan_->GetGlobalObjects()->count(address)) {
+    Error err;
+    return v8::HeapObject(llscan_->v8(), address).GetTypeName(err);
+  }
+
+  if (llscan_->GetContexts()->count(address)) {
+    Error err;
+    v8::Context c(llscan_->v8(), address);
+    if (c.IsNative(err)) return "native context";
+  }
+
+  return std::string();
+}
+
+
+std::string RetainersCmd::EdgeName(uint64_t holder, uint64_t value) {
+  v8::LLV8* v8 = llscan_->v8();
+  Error err;
+  char buf[64];
+
+  if (llscan_->GetContexts()->count(holder)) {
+    v8::Context c(v8, holder);
+    v8::Context::Locals locals(&c, err);
+    if (err.Success()) {
+      for (v8::Context::Locals::Iterator it = locals.begin();
+           it != locals.end(); it++) {
+        if ((*it).raw() != static_cast<int64_t>(value)) continue;
+        v8::String name = it.LocalName(err);
+        if (err.Success()) {
+          std::string local = name.ToString(err);
+          if (err.Success()) return "." + local;
+        }
+        return ".???";
+      }
+    }
+    return "<previous>";
+  }
+
+  if (llscan_->GetFunctions()->count(holder)) return "<context>";
+
+  v8::HeapObject heap_object(v8, holder);
+  int64_t type = heap_object.GetType(err);
+  if (err.Fail()) return "";
+
+  if (type < v8->types()->kFirstNonstringType) {
+    v8::String str(heap_object);
+    v8::CheckedType<int64_t> repr = str.Representation(err);
+    RETURN_IF_INVALID(repr, "");
+    if (*repr == v8->string()->kSlicedStringTag) return "<Parent>";
+    if (*repr == v8->string()->kThinStringTag) return "<Actual>";
+    if (*repr == v8->string()->kConsStringTag) {
+      v8::ConsString cons_str(str);
+      v8::String first = cons_str.First(err);
+      return first.raw() == static_cast<int64_t>(value) ? "<First>"
+                                                        : "<Second>";
+    }
+    return "";
+  }
+
+  v8::JSObject js_obj(heap_object);
+  int64_t length = js_obj.GetArrayLength(err);
+  for (int64_t i = 0; err.Success() && i < length; ++i) {
+    v8::Value v = js_obj.GetArrayElement(i, err);
+    if (err.Success() && v.raw() == static_cast<int64_t>(value)) {
+      snprintf(buf, sizeof(buf), "[%" PRId64 "]", i);
+      return buf;
+    }
+  }
+
+  err = Error::Ok();
+  for (auto entry : js_obj.Entries(err)) {
+    if (entry.second.raw() != static_cast<int64_t>(value)) continue;
+    Error key_err;
+    return "." + entry.first.ToString(key_err);
+  }
+
+  return "";
+}
+
+
+bool ArrayBuffersCmd::DoExecute(SBDebugger d, char** cmd,
+                                SBCommandReturnObject& result) {
+  SBTarget target = d.GetSelectedTarget();
+  if (!target.IsValid()) {
+    result.SetError("No valid process, please start something\n");
+    return false;
+  }
+
+  Printer::PrinterOptions printer_options;
+  ParsePrinterOptions(cmd, &printer_options);
+  int output_limit = printer_options.output_limit > 0
+                         ? printer_options.output_limit
+                         : kDefaultOutputLimit;
+
+  // Load V8 constants from postmortem data
+  llscan_->v8()->Load(target);
+
+  /* Ensure we have a map of objects. */
+  if (!llscan_->ScanHeapForObjects(target, result)) {
+    result.SetStatus(eReturnStatusFailed);
+    return false;
+  }
+
+  std::map<uint64_t, BufferInfo> buffers;
+  for (uint64_t addr : *llscan_->GetArrayBuffers()) {
+    BufferInfo info = {addr, 0, 0, 0, 0};
+    buffers.emplace(addr, info);
+  }
+
+  // Views keep their buffer alive, so they also find buffers the scan missed.
+  uint64_t total_views = 0;
+  TypeRecordMap::iterator views_it =
+      llscan_->GetMapsToInstances().find("(ArrayBufferView)");
+  if (views_it != llscan_->GetMapsToInstances().end()) {
+    for (uint64_t addr : views_it->second->GetInstances()) {
+      Error err;
+      v8::JSTypedArray view(llscan_->v8(), addr);
+      v8::JSArrayBuffer buffer = view.Buffer(err);
+      if (err.Fail() || !buffer.Check()) continue;
+
+      BufferInfo info = {static_cast<uint64_t>(buffer.raw()), 0, 0, 0, addr};
+      BufferInfo& buffer_info =
+          buffers.emplace(buffer.raw(), info).first->second;
+      if (buffer_info.view_count++ == 0) buffer_info.sample_view = addr;
+      total_views++;
+    }
+  }
+
+  uint64_t detached_count = 0;
+  uint64_t total_external_bytes = 0;
+  std::vector<BufferInfo> holders;
+  std::map<uint64_t, std::vector<uint64_t>> buffers_by_backing_store;
+
+  for (auto& entry : buffers) {
+    Error err;
+    BufferInfo& info = entry.second;
+    v8::JSArrayBuffer buffer(llscan_->v8(), info.address);
+
+    bool neutered = buffer.WasNeutered(err);
+    if (err.Fail()) continue;
+    if (neutered) {
+      detached_count++;
+      continue;
+    }
+
+    v8::CheckedType<uintptr_t> backing_store = buffer.BackingStore();
+    v8::CheckedType<size_t> byte_length = buffer.ByteLength();
+    if (!backing_store.Check() || !byte_length.Check()) continue;
+    if (*backing_store == 0) continue;
+
+    info.backing_store = *backing_store;
+    info.byte_length = *byte_length;
+    holders.push_back(info);
+
+    auto& sharing = buffers_by_backing_store[info.backing_store];
+    // Count memory once per backing store, it might be shared.
+    if (sharing.empty()) total_external_bytes += info.byte_length;
+    sharing.push_back(info.address);
+  }
+
+  std::sort(holders.begin(), holders.end(),
+            [](const BufferInfo& a, const BufferInfo& b) {
+              if (a.byte_length == b.byte_length) return a.address < b.address;
+              return a.byte_length > b.byte_length;
+            });
+
+  result.Printf("%" PRId64 " ArrayBuffers (%" PRId64 " detached), %" PRId64
+                " views, %" PRId64 " external bytes in %" PRId64
+                " backing stores\n\n",
+                buffers.size(), detached_count, total_views,
+                total_external_bytes, buffers_by_backing_store.size());
+
+  result.Printf("  Byte Length  Views        ArrayBuffer      Backing Store\n");
+  result.Printf(" ------------ ------ ------------------ ------------------\n");
+  int printed = 0;
+  for (auto& info : holders) {
+    if (printed++ == output_limit) {
+      result.Printf(" ..........\n");
+      break;
+    }
+    result.Printf(" %12" PRId64 " %6" PRId64 " 0x%016" PRIx64 " 0x%016" PRIx64
+                  "\n",
+                  info.byte_length, info.view_count, info.address,
+                  info.backing_store);
+  }
+
+  bool printed_header = false;
+  for (auto& entry : buffers_by_backing_store) {
+    if (entry.second.size() < 2) continue;
+
+    if (!printed_header) {
+      result.Printf("\nBacking stores shared by several ArrayBuffers:\n");
+      printed_header = true;
+    }
+    result.Printf(" 0x%016" PRIx64 ":", entry.first);
+    for (uint64_t addr : entry.second) result.Printf(" 0x%016" PRIx64, addr);
+    result.Printf("\n");
+  }
+
+  result.SetStatus(eReturnStatusSuccessFinishResult);
+  return true;
+}
+
+
+bool TimersCmd::GetNumber(v8::Value value, double* number) {
+  v8::Smi smi(value);
+  if (smi.Check()) {
+    *number = smi.GetValue();
+    return true;
+  }
+
+  Error err;
+  v8::HeapObject obj(value);
+  if (!obj.Check()) return false;
+  int64_t type = obj.GetType(err);
+  if (err.Fail() || type != value.v8()->types()->kHeapNumberType) return false;
+
+  v8::HeapNumber heap_number(obj);
+  v8::CheckedType<double> result = heap_number.GetValue(err);
+  if (err.Fail() || !result.Check()) return false;
+  *number = *result;
+  return true;
+}
+
+
+bool TimersCmd::DoExecute(SBDebugger d, char** cmd,
+                          SBCommandReturnObject& result) {
+  SBTarget target = d.GetSelectedTarget();
+  if (!target.IsValid()) {
+    result.SetError("No valid process, please start something\n");
+    return false;
+  }
+
+  Printer::PrinterOptions printer_options;
+  ParsePrinterOptions(cmd, &printer_options);
+  int output_limit = printer_options.output_limit > 0
+                         ? printer_options.output_limit
+                         : kDefaultOutputLimit;
+
+  // Load V8 constants from postmortem data
+  llscan_->v8()->Load(target);
+
+  /* Ensure we have a map of objects. */
+  if (!llscan_->ScanHeapForObjects(target, result)) {
+    result.SetStatus(eReturnStatusFailed);
+    return false;
+  }
+
+  // setTimeout() and setInterval() return instances of lib/internal/timers'
+  // Timeout class.
+  TypeRecordMap::iterator timeouts_it =
+      llscan_->GetMapsToInstances().find("Timeout");
+  if (timeouts_it == llscan_->GetMapsToInstances().end()) {
+    result.Printf("No timers found\n");
+    result.SetStatus(eReturnStatusSuccessFinishResult);
+    return true;
+  }
+
+  uint64_t total = 0;
+  uint64_t inactive = 0;
+  std::map<double, TimerGroup> groups;
+  for (uint64_t addr : timeouts_it->second->GetInstances()) {
+    Error err;
+    v8::JSObject timeout(llscan_->v8(), addr);
+
+    // Cleared timers have _idleTimeout set to -1, fired ones are destroyed.
+    double duration = -1;
+    double start = 0;
+    v8::Value destroyed_value = timeout.GetProperty("_destroyed", err);
+    v8::HeapObject destroyed(destroyed_value);
+    if (err.Success() && destroyed.Check() &&
+        destroyed.GetType(err) == llscan_->v8()->types()->kOddballType) {
+      v8::Oddball oddball(destroyed);
+      v8::Smi kind = oddball.Kind(err);
+      if (err.Success() && kind.GetValue() == llscan_->v8()->oddball()->kTrue) {
+        inactive++;
+        continue;
+      }
+    }
+    err = Error();
+    if (!GetNumber(timeout.GetProperty("_idleTimeout", err), &duration) ||
+        duration < 0 ||
+        !GetNumber(timeout.GetProperty("_idleStart", err), &start)) {
+      inactive++;
+      continue;
+    }
+    err = Error();
+
+    TimerGroup& group = groups[duration];
+    double expiry = start + duration;
+    if (group.count++ == 0 || expiry < group.first_expiry) {
+      group.first_expiry = expiry;
+      group.first_timer = addr;
+    }
+    total++;
+
+    double repeat;
+    if (GetNumber(timeout.GetProperty("_repeat", err), &repeat))
+      group.repeating++;
+    err = Error();
+
+    std::string callback = "<unknown>";
+    v8::Value on_timeout_value = timeout.GetProperty("_onTimeout", err);
+    v8::HeapObject on_timeout(on_timeout_value);
+    if (err.Success() && on_timeout.Check() &&
+        on_timeout.GetType(err) == llscan_->v8()->types()->kJSFunctionType) {
+      v8::JSFunction fn(on_timeout);
+      callback = fn.Name(err);
+      if (err.Fail() || callback.empty()) callback = "(anonymous)";
+    }
+    group.callbacks[callback]++;
+  }
+
+  result.Printf("%" PRId64 " active timers in %" PRId64
+                " durations, %" PRId64 " cleared or fired\n",
+                total, groups.size(), inactive);
+  if (groups.empty()) {
+    result.SetStatus(eReturnStatusSuccessFinishResult);
+    return true;
+  }
+
+  // Earliest expiry first, that's the order in which they will fire.
+  std::vector<std::pair<double, TimerGroup*>> sorted;
+  for (auto& entry : groups) sorted.emplace_back(entry.first, &entry.second);
+  std::sort(sorted.begin(), sorted.end(),
+            [](const std::pair<double, TimerGroup*>& a,
+               const std::pair<double, TimerGroup*>& b) {
+              return a.second->first_expiry < b.second->first_expiry;
+            });
+
+  result.Printf("\n Duration (ms)   Count Repeat  First expiry         "
+                "First timer  Callbacks\n");
+  result.Printf(" ------------- ------- ------ ------------- "
+                "------------------ ---------\n");
+  int printed = 0;
+  for (auto& entry : sorted) {
+    if (printed++ == output_limit) {
+      result.Printf(" ..........\n");
+      break;
+    }
+
+    TimerGroup* group = entry.second;
+    std::string callbacks;
+    for (auto& callback : group->callbacks) {
+      if (!callbacks.empty()) callbacks += ", ";
+      callbacks += callback.first;
+      if (callback.second > 1)
+        callbacks += " (" + std::to_string(callback.second) + ")";
+    }
+
+    result.Printf(" %13.0f %7" PRId64 " %6" PRId64 " %13.0f 0x%016" PRIx64
+                  "  %s\n",
+                  entry.first, group->count, group->repeating,
+                  group->first_expiry, group->first_timer, callbacks.c_str());
+  }
+
+  result.SetStatus(eReturnStatusSuccessFinishResult);
+  return true;
+}
+
+
+uint64_t ContextsCmd::ValueSize(v8::Value value) {
+  v8::HeapObject heap_object(value);
+  if (!heap_object.Check()) return 0;
+
+  Error err;
+  v8::LLV8* v8 = heap_object.v8();
+  int64_t type = heap_object.GetType(err);
+  if (err.Fail()) return 0;
+
+  // Strings are variable sized, count their characters.
+  if (type < v8->types()->kFirstNonstringType) {
+    v8::String str(heap_object);
+    v8::CheckedType<int32_t> length = str.Length(err);
+    if (err.Fail() || !length.Check()) return 0;
+    int64_t encoding = str.Encoding(err);
+    if (err.Fail()) return 0;
+    return encoding == v8->string()->kTwoByteStringTag ? *length * 2
+                                                       : *length;
+  }
+
+  v8::HeapObject map_obj = heap_object.GetMap(err);
+  if (err.Fail()) return 0;
+  v8::Map map(map_obj);
+  int64_t size = map.InstanceSize(err);
+  if (err.Fail() || size < 0) return 0;
+
+  if (type == v8->types()->kJSArrayType) {
+    v8::JSObject js_obj(heap_object);
+    int64_t length = js_obj.GetArrayLength(err);
+    if (err.Success() && length > 0)
+      size += length * v8->common()->kPointerSize;
+  }
+  return size;
+}
+
+
+char** ContextsCmd::ParseOptions(char** cmd, int* count) {
+  static struct option opts[] = {
+      {"output-limit", required_argument, nullptr, 'n'},
+      {"top", required_argument, nullptr, 'n'},
+      {nullptr, 0, nullptr, 0}};
+
+  int argc = 1;
+  for (char** p = cmd; p != nullptr && *p != nullptr; p++) argc++;
+
+  char* args[argc];
+
+  // Make this look like a command line, we need a valid element at index 0
+  // for getopt_long to use in its error messages.
+  char name[] = "llnode";
+  args[0] = name;
+  for (int i = 0; i < argc - 1; i++) args[i + 1] = cmd[i];
+
+  // Reset getopts.
+  optind = 0;
+  opterr = 1;
+  do {
+    int arg = getopt_long(argc, args, "n:", opts, nullptr);
+    if (arg == -1) break;
+
+    if (arg == 'n') {
+      int number = strtol(optarg, nullptr, 10);
+      if (number > 0) *count = number;
+    }
+  } while (true);
+
+  return &cmd[optind - 1];
+}
+
+
+bool ContextsCmd::DoExecute(SBDebugger d, char** cmd,
+                            SBCommandReturnObject& result) {
+  SBTarget target = d.GetSelectedTarget();
+  if (!target.IsValid()) {
+    result.SetError("No valid process, please start something\n");
+    return false;
+  }
+
+  int output_limit = kDefaultOutputLimit;
+  ParseOptions(cmd, &output_limit);
+
+  // Load V8 constants from postmortem data
+  llscan_->v8()->Load(target);
+
+  /* Ensure we have a map of objects. */
+  if (!llscan_->ScanHeapForObjects(target, result)) {
+    result.SetStatus(eReturnStatusFailed);
+    return false;
+  }
+
+  v8::LLV8* v8 = llscan_->v8();
+  std::unordered_map<uint64_t, ContextGroup> groups;
+  uint64_t contexts = 0;
+  uint64_t unreadable = 0;
+  for (uint64_t ctx : *llscan_->GetContexts()) {
+    Error err;
+    v8::Context c(v8, ctx);
+
+    // Native contexts have no function, and hold the whole realm.
+    if (c.IsNative(err)) continue;
+
+    v8::HeapObject scope_obj = c.GetScopeInfo(err);
+    if (err.Fail()) {
+      unreadable++;
+      continue;
+    }
+    v8::Context::Locals locals(&c, err);
+    if (err.Fail()) {
+      unreadable++;
+      continue;
+    }
+
+    contexts++;
+    ContextGroup& group = groups[scope_obj.raw()];
+    if (group.count++ == 0) {
+      v8::ScopeInfo scope(scope_obj);
+      Error name_err;
+      v8::HeapObject name = scope.MaybeFunctionName(name_err);
+      if (name_err.Success())
+        group.function_name = v8::String(name).ToString(name_err);
+      if (name_err.Fail() || group.function_name.empty())
+        group.function_name = "(anonymous)";
+    }
+
+    for (v8::Context::Locals::Iterator it = locals.begin(); it != locals.end();
+         it++) {
+      group.slots++;
+      v8::Value value = *it;
+      uint64_t size = ValueSize(value);
+      group.bytes += size;
+      if (size <= group.largest_size) continue;
+
+      group.largest_size = size;
+      group.largest_value = value.raw();
+      Error name_err;
+      group.largest_name = it.LocalName(name_err).ToString(name_err);
+      if (name_err.Fail()) group.largest_name = "???";
+    }
+  }
+
+  result.Printf("%" PRIu64 " function contexts from %zu functions", contexts,
+                groups.size());
+  if (unreadable > 0) result.Printf(", %" PRIu64 " unreadable", unreadable);
+  result.Printf("\n");
+  if (groups.empty()) {
+    result.SetStatus(eReturnStatusSuccessFinishResult);
+    return true;
+  }
+
+  // Most bytes held through slots first.
+  std::vector<std::pair<uint64_t, ContextGroup*>> sorted;
+  for (auto& entry : groups) sorted.emplace_back(entry.first, &entry.second);
+  std::sort(sorted.begin(), sorted.end(),
+            [](const std::pair<uint64_t, ContextGroup*>& a,
+               const std::pair<uint64_t, ContextGroup*>& b) {
+              if (a.second->bytes != b.second->bytes)
+                return a.second->bytes > b.second->bytes;
+              return a.second->count > b.second->count;
+            });
+
+  result.Printf("\n Contexts    Slots  Slot bytes          ScopeInfo  "
+                "Function: largest slot\n");
+  result.Printf(" -------- -------- ----------- ------------------  "
+                "----------------------\n");
+  int printed = 0;
+  for (auto& entry : sorted) {
+    if (printed++ == output_limit) {
+      result.Printf(" ..........\n");
+      break;
+    }
+
+    ContextGroup* group = entry.second;
+    result.Printf(" %8" PRIu64 " %8" PRIu64 " %11" PRIu64 " 0x%016" PRIx64
+                  "  %s",
+                  group->count, group->slots, group->bytes, entry.first,
+                  group->function_name.c_str());
+    if (group->largest_size > 0) {
+      result.Printf(": %s=0x%016" PRIx64 " (%" PRIu64 " bytes)",
+                    group->largest_name.c_str(), group->largest_value,
+                    group->largest_size);
+    }
+    result.Printf("\n");
+  }
+
+  result.SetStatus(eReturnStatusSuccessFinishResult);
+  return true;
+}
+
+
+bool CollectionsCmd::DoExecute(SBDebugger d, char** cmd,
+                               SBCommandReturnObject& result) {
+  SBTarget target = d.GetSelectedTarget();
+  if (!target.IsValid()) {
+    result.SetError("No valid process, please start something\n");
+    return false;
+  }
+
+  Printer::PrinterOptions printer_options;
+  ParsePrinterOptions(cmd, &printer_options);
+  int output_limit = printer_options.output_limit > 0
+                         ? printer_options.output_limit
+                         : kDefaultOutputLimit;
+
+  // Load V8 constants from postmortem data
+  llscan_->v8()->Load(target);
+
+  /* Ensure we have a map of objects. */
+  if (!llscan_->ScanHeapForObjects(target, result)) {
+    result.SetStatus(eReturnStatusFailed);
+    return false;
+  }
+
+  std::vector<CollectionInfo> collections;
+  int64_t total_size = 0;
+  int64_t total_table_size = 0;
+  for (uint64_t addr : *llscan_->GetCollections()) {
+    Error err;
+    v8::JSCollection collection(llscan_->v8(), addr);
+
+    CollectionInfo info;
+    info.address = addr;
+    info.kind = collection.GetKind(err);
+    info.size = collection.Size(err);
+    info.table_size = collection.TableSize(err);
+    if (err.Fail()) continue;
+
+    total_size += info.size;
+    total_table_size += info.table_size;
+    collections.push_back(info);
+  }
+
+  result.Printf("%zu collections, %" PRId64 " entries in %" PRId64
+                " bytes of hash tables\n",
+                collections.size(), total_size, total_table_size);
+  if (collections.empty()) {
+    result.SetStatus(eReturnStatusSuccessFinishResult);
+    return true;
+  }
+
+  // Most entries first, then largest tables (e.g. after many deletions).
+  std::sort(collections.begin(), collections.end(),
+            [](const CollectionInfo& a, const CollectionInfo& b) {
+              if (a.size != b.size) return a.size > b.size;
+              return a.table_size > b.table_size;
+            });
+
+  result.Printf("\n    Entries  Table bytes  Kind              Address\n");
+  result.Printf(" ---------- ------------  ------- ------------------\n");
+  int printed = 0;
+  for (const CollectionInfo& info : collections) {
+    if (printed++ == output_limit) {
+      result.Printf(" ..........\n");
+      break;
+    }
+
+    result.Printf(" %10" PRId64 " %12" PRId64 "  %-7s 0x%016" PRIx64 "\n",
+                  info.size, info.table_size,
+                  v8::JSCollection::KindName(info.kind), info.address);
+  }
+
+  result.SetStatus(eReturnStatusSuccessFinishResult);
+  return true;
+}
+
+
+std::string PromisesCmd::HandlerName(v8::JSPromise::Reaction& reaction,
+                                     Error& err) {
+  if (reaction.async_function.Check()) {
+    std::string name = reaction.async_function.Name(err);
+    return "await in " + (name.empty() ? "(anonymous)" : name);
+  }
+
+  v8::HeapObject handler(reaction.handler);
+  if (!handler.Check()) return "(none)";
+
+  int64_t type = handler.GetType(err);
+  if (err.Fail()) return std::string();
+  if (type != handler.v8()->types()->kJSFunctionType)
+    return handler.GetTypeName(err);
+
+  v8::JSFunction fn(handler);
+  std::string name = fn.Name(err);
+  return name.empty() ? "(anonymous)" : name;
+}
+
+
+bool PromisesCmd::DoExecute(SBDebugger d, char** cmd,
+                            SBCommandReturnObject& result) {
+  SBTarget target = d.GetSelectedTarget();
+  if (!target.IsValid()) {
+    result.SetError("No valid process, please start something\n");
+    return false;
+  }
+
+  Printer::PrinterOptions printer_options;
+  ParsePrinterOptions(cmd, &printer_options);
+  int output_limit = printer_options.output_limit > 0
+                         ? printer_options.output_limit
+                         : kDefaultOutputLimit;
+
+  // Load V8 constants from postmortem data
+  llscan_->v8()->Load(target);
+
+  /* Ensure we have a map of objects. */
+  if (!llscan_->ScanHeapForObjects(target, result)) {
+    result.SetStatus(eReturnStatusFailed);
+    return false;
+  }
+
+  // Decode every promise once, remembering which pending promise settles
+  // which.
+  int64_t statuses[v8::JSPromise::kRejected + 1] = {0};
+  std::vector<uint64_t> unhandled;
+  std::unordered_map<uint64_t, PendingPromise> pending;
+  std::unordered_map<std::string, int64_t> handlers;
+  int64_t total_reactions = 0;
+  struct Edge {
+    uint64_t promise;
+    uint64_t next;
+    std::string handler;
+  };
+  std::vector<Edge> edges;
+  for (uint64_t addr : *llscan_->GetPromises()) {
+    Error err;
+    v8::JSPromise promise(llscan_->v8(), addr);
+
+    v8::JSPromise::Status status = promise.GetStatus(err);
+    if (err.Fail()) continue;
+    statuses[status]++;
+
+    if (status == v8::JSPromise::kRejected) {
+      bool has_handler = promise.HasHandler(err);
+      if (err.Success() && !has_handler) unhandled.push_back(addr);
+      continue;
+    }
+    if (status != v8::JSPromise::kPending) continue;
+
+    pending[addr];
+    std::vector<v8::JSPromise::Reaction> reactions = promise.Reactions(err);
+    if (err.Fail()) continue;
+
+    for (v8::JSPromise::Reaction& reaction : reactions) {
+      Error name_err;
+      std::string name = HandlerName(reaction, name_err);
+      if (name_err.Fail() || name.empty()) name = "???";
+
+      handlers[name]++;
+      total_reactions++;
+      if (reaction.next.Check())
+        edges.push_back({addr, static_cast<uint64_t>(reaction.next.raw()),
+                         name});
+    }
+  }
+
+  result.Printf("%zu promises: %" PRId64 " pending, %" PRId64
+                " fulfilled, %" PRId64 " rejected (%zu unhandled)\n",
+                llscan_->GetPromises()->size(),
+                statuses[v8::JSPromise::kPending],
+                statuses[v8::JSPromise::kFulfilled],
+                statuses[v8::JSPromise::kRejected], unhandled.size());
+
+  if (!handlers.empty()) {
+    std::vector<std::pair<std::string, int64_t>> sorted(handlers.begin(),
+                                                         handlers.end());
+    std::sort(sorted.begin(), sorted.end(),
+              [](const std::pair<std::string, int64_t>& a,
+                 const std::pair<std::string, int64_t>& b) {
+                if (a.second != b.second) return a.second > b.second;
+                return a.first < b.first;
+              });
+
+    result.Printf("\n%" PRId64 " reactions waiting on pending promises:\n",
+                  total_reactions);
+    result.Printf("  Reactions  Handler\n");
+    result.Printf(" ----------  -------\n");
+    int printed = 0;
+    for (auto& handler : sorted) {
+      if (printed++ == output_limit) {
+        result.Printf(" ..........\n");
+        break;
+      }
+      result.Printf(" %10" PRId64 "  %s\n", handler.second,
+                    handler.first.c_str());
+    }
+  }
+
+  // Link the pending promises, a settled one doesn't keep anything waiting.
+  for (Edge& edge : edges) {
+    auto next = pending.find(edge.next);
+    if (next == pending.end() || edge.next == edge.promise) continue;
+    pending.at(edge.promise).next.push_back(edge.next);
+    next->second.has_previous = true;
+    next->second.tail_handler = edge.handler;
+  }
+
+  // Longest chain from each promise nothing else waits on, computed
+  // bottom-up without recursion since chains can be very long. Promises in
+  // a cycle are left out.
+  std::vector<uint64_t> heads;
+  std::vector<std::pair<uint64_t, size_t>> stack;
+  for (auto& entry : pending) {
+    if (entry.second.has_previous) continue;
+    heads.push_back(entry.first);
+
+    entry.second.chain_length = -1;
+    stack.emplace_back(entry.first, 0);
+    while (!stack.empty()) {
+      uint64_t addr = stack.back().first;
+      size_t index = stack.back().second++;
+      PendingPromise& current = pending.at(addr);
+
+      if (index < current.next.size()) {
+        PendingPromise& next = pending.at(current.next[index]);
+        if (next.chain_length == 0) {
+          next.chain_length = -1;
+          stack.emplace_back(current.next[index], 0);
+        }
+        continue;
+      }
+
+      current.chain_length = 1;
+      current.chain_tail = addr;
+      for (uint64_t next_addr : current.next) {
+        PendingPromise& next = pending.at(next_addr);
+        if (next.chain_length + 1 > current.chain_length) {
+          current.chain_length = next.chain_length + 1;
+          current.chain_tail = next.chain_tail;
+        }
+      }
+      stack.pop_back();
+    }
+  }
+
+  std::sort(heads.begin(), heads.end(), [&pending](uint64_t a, uint64_t b) {
+    return pending.at(a).chain_length > pending.at(b).chain_length;
+  });
+  if (!heads.empty() && pending.at(heads.front()).chain_length > 1) {
+    result.Printf("\nLongest chains of pending promises:\n");
+    result.Printf("     Length  Head               Tail               "
+                  "Tail handler\n");
+    result.Printf(" ---------- ------------------ ------------------ "
+                  "------------\n");
+    int printed = 0;
+    for (uint64_t head : heads) {
+      PendingPromise& chain = pending.at(head);
+      if (chain.chain_length < 2) break;
+      if (printed++ == output_limit) {
+        result.Printf(" ..........\n");
+        break;
+      }
+      result.Printf(" %10" PRId64 " 0x%016" PRIx64 " 0x%016" PRIx64 " %s\n",
+                    chain.chain_length, head, chain.chain_tail,
+                    pending.at(chain.chain_tail).tail_handler.c_str());
+    }
+  }
+
+  if (!unhandled.empty()) {
+    result.Printf("\nRejected promises without a handler:\n");
+    Printer printer(llscan_->v8());
+    int printed = 0;
+    for (uint64_t addr : unhandled) {
+      if (printed++ == output_limit) {
+        result.Printf(" ..........\n");
+        break;
+      }
+      Error err;
+      v8::JSPromise promise(llscan_->v8(), addr);
+      v8::Value reason = promise.Result(err);
+      std::string res = err.Success() ? printer.Stringify(reason, err) : "";
+      if (err.Fail()) res = "???";
+      result.Printf(" 0x%016" PRIx64 ": %s\n", addr, res.c_str());
+    }
+  }
+
+  result.SetStatus(eReturnStatusSuccessFinishResult);
+  return true;
+}
+
+
+bool MapsCmd::DoExecute(SBDebugger d, char** cmd,
+                        SBCommandReturnObject& result) {
+  SBTarget target = d.GetSelectedTarget();
+  if (!target.IsValid()) {
+    result.SetError("No valid process, please start something\n");
+    return false;
+  }
+
+  Printer::PrinterOptions printer_options;
+  ParsePrinterOptions(cmd, &printer_options);
+  int output_limit = printer_options.output_limit > 0
+                         ? printer_options.output_limit
+                         : kDefaultOutputLimit;
+
+  // Load V8 constants from postmortem data
+  llscan_->v8()->Load(target);
+
+  /* Ensure we have a map of objects. */
+  if (!llscan_->ScanHeapForObjects(target, result)) {
+    result.SetStatus(eReturnStatusFailed);
+    return false;
+  }
+
+  // Everything comes from the Maps recorded by the scan.
+  std::unordered_map<std::string, MapGroup> by_site;
+  std::unordered_map<uint64_t, MapGroup> by_root;
+  MapGroup total;
+  for (auto& entry : llscan_->GetMaps()) {
+    const MapRecord& record = entry.second;
+    MapGroup& site = by_site[record.site];
+    MapGroup& tree = by_root[record.root];
+    for (MapGroup* group : {&site, &tree, &total}) {
+      group->maps++;
+      group->instances += record.instance_count;
+      if (record.is_dictionary) {
+        group->dictionary_maps++;
+        group->dictionary_instances += record.instance_count;
+        group->dictionary_size += record.instance_size + record.dictionary_size;
+      }
+    }
+    site.site = record.site;
+    tree.site = record.site;
+    tree.root = record.root;
+    tree.depth = std::max(tree.depth, record.depth);
+  }
+
+  result.Printf("%" PRIu64 " maps used by %" PRIu64 " objects, %" PRIu64
+                " objects in dictionary mode using %" PRIu64 " bytes\n",
+                total.maps, total.instances, total.dictionary_instances,
+                total.dictionary_size);
+
+  std::vector<MapGroup*> groups;
+  auto print = [&](const char* title, const char* header,
+                   std::function<bool(MapGroup*, MapGroup*)> compare,
+                   std::function<bool(MapGroup*)> skip,
+                   std::function<void(MapGroup*)> row) {
+    std::sort(groups.begin(), groups.end(), compare);
+    if (groups.empty() || skip(groups.front())) return;
+
+    result.Printf("\n%s:\n%s\n", title, header);
+    int printed = 0;
+    for (MapGroup* group : groups) {
+      if (skip(group)) break;
+      if (printed++ == output_limit) {
+        result.Printf(" ..........\n");
+        break;
+      }
+      row(group);
+    }
+  };
+
+  // Many Maps for one constructor means polymorphic shapes.
+  for (auto& entry : by_site) groups.push_back(&entry.second);
+  print("Constructors with the most maps",
+        "       Maps  Instances  Dict. maps  Constructor\n"
+        " ---------- ---------- -----------  -----------",
+        [](MapGroup* a, MapGroup* b) {
+          if (a->maps != b->maps) return a->maps > b->maps;
+          return a->instances > b->instances;
+        },
+        [](MapGroup* group) { return group->maps < 2; },
+        [&](MapGroup* group) {
+          result.Printf(" %10" PRIu64 " %10" PRIu64 " %11" PRIu64 "  %s\n",
+                        group->maps, group->instances, group->dictionary_maps,
+                        group->site.c_str());
+        });
+
+  print("Dictionary mode objects",
+        "    Objects       Bytes  Constructor\n"
+        " ---------- -----------  -----------",
+        [](MapGroup* a, MapGroup* b) {
+          if (a->dictionary_size != b->dictionary_size)
+            return a->dictionary_size > b->dictionary_size;
+          return a->dictionary_instances > b->dictionary_instances;
+        },
+        [](MapGroup* group) { return group->dictionary_instances == 0; },
+        [&](MapGroup* group) {
+          result.Printf(" %10" PRIu64 " %11" PRIu64 "  %s\n",
+                        group->dictionary_instances, group->dictionary_size,
+                        group->site.c_str());
+        });
+
+  groups.clear();
+  for (auto& entry : by_root) groups.push_back(&entry.second);
+  print("Deepest transition trees",
+        "      Depth       Maps  Instances  Root map            Constructor\n"
+        " ---------- ---------- ----------  ------------------  -----------",
+        [](MapGroup* a, MapGroup* b) {
+          if (a->depth != b->depth) return a->depth > b->depth;
+          return a->maps > b->maps;
+        },
+        [](MapGroup* group) { return group->depth == 0; },
+        [&](MapGroup* group) {
+          result.Printf(" %10" PRId64 " %10" PRIu64 " %10" PRIu64
+                        "  0x%016" PRIx64 "  %s\n",
+                        group->depth, group->maps, group->instances,
+                        group->root, group->site.c_str());
+        });
+
+  result.SetStatus(eReturnStatusSuccessFinishResult);
+  return true;
+}
+
+
+namespace {
+
+// A type or site present in either scan.
+struct TypeDelta {
+  std::string name;
+  TypeRecord* baseline;
+  TypeRecord* current;
+  int64_t count_delta;
+  int64_t size_delta;
+};
+
+// Both maps are sorted by name, so one pass over each pairs their records.
+std::vector<TypeDelta> DiffTypeRecords(TypeRecordMap& baseline,
+                                       TypeRecordMap& current) {
+  std::vector<TypeDelta> deltas;
+  auto b = baseline.begin();
+  auto c = current.begin();
+  while (b != baseline.end() || c != current.end()) {
+    TypeDelta delta = {"", nullptr, nullptr, 0, 0};
+    if (c == current.end() || (b != baseline.end() && b->first < c->first)) {
+      delta.name = b->first;
+      delta.baseline = (b++)->second;
+    } else if (b == baseline.end() || c->first < b->first) {
+      delta.name = c->first;
+      delta.current = (c++)->second;
+    } else {
+      delta.name = c->first;
+      delta.baseline = (b++)->second;
+      delta.current = (c++)->second;
+    }
+
+    if (delta.current != nullptr) {
+      delta.count_delta += delta.current->GetInstanceCount();
+      delta.size_delta += delta.current->GetTotalInstanceSize();
+    }
+    if (delta.baseline != nullptr) {
+      delta.count_delta -= delta.baseline->GetInstanceCount();
+      delta.size_delta -= delta.baseline->GetTotalInstanceSize();
+    }
+    if (delta.count_delta != 0 || delta.size_delta != 0)
+      deltas.push_back(delta);
+  }
+
+  std::sort(deltas.begin(), deltas.end(),
+            [](const TypeDelta& a, const TypeDelta& b) {
+              if (a.count_delta != b.count_delta)
+                return a.count_delta > b.count_delta;
+              if (a.size_delta != b.size_delta)
+                return a.size_delta > b.size_delta;
+              return a.name < b.name;
+            });
+  return deltas;
+}
+
+// Up to `count` instances of a delta which the baseline doesn't have.
+// Objects which survived in old space keep their address.
+typedef std::function<std::vector<uint64_t>(const TypeDelta& delta,
+                                            size_t count)>
+    SampleFunction;
+
+std::vector<uint64_t> NewTypeInstances(const TypeDelta& delta, size_t count) {
+  std::vector<uint64_t> samples;
+  for (uint64_t addr : delta.current->GetInstances()) {
+    if (delta.baseline != nullptr &&
+        delta.baseline->GetInstances().count(addr) != 0)
+      continue;
+    samples.push_back(addr);
+    if (samples.size() == count) break;
+  }
+  return samples;
+}
+
+// Sites don't keep the addresses of their instances, look for them in the
+// types of their Maps instead.
+std::vector<uint64_t> NewSiteInstances(LLScan* baseline, LLScan* current,
+                                       const TypeDelta& delta, size_t count) {
+  std::unordered_set<uint64_t> maps;
+  std::set<std::string> types;
+  for (auto& entry : current->GetMaps()) {
+    if (entry.second.site != delta.name) continue;
+    maps.insert(entry.first);
+    types.insert(entry.second.type_name);
+  }
+
+  std::vector<uint64_t> samples;
+  TypeRecordMap& baseline_types = baseline->GetMapsToInstances();
+  for (const std::string& type : types) {
+    auto c = current->GetMapsToInstances().find(type);
+    if (c == current->GetMapsToInstances().end()) continue;
+    auto b = baseline_types.find(type);
+    TypeRecord* old = b == baseline_types.end() ? nullptr : b->second;
+
+    for (uint64_t addr : c->second->GetInstances()) {
+      if (old != nullptr && old->GetInstances().count(addr) != 0) continue;
+      Error err;
+      v8::HeapObject object(current->v8(), addr);
+      v8::HeapObject map = object.GetMap(err);
+      if (err.Fail() || maps.count(map.raw()) == 0) continue;
+      samples.push_back(addr);
+      if (samples.size() == count) return samples;
+    }
+  }
+  return samples;
+}
+
+void PrintTypeDeltas(SBCommandReturnObject& result, const char* title,
+                     std::vector<TypeDelta>& deltas, int output_limit,
+                     SampleFunction sample) {
+  const size_t kSamples = 3;
+
+  result.Printf("\n%s:\n", title);
+  result.Printf(" Count diff   Size diff      Count        Size Name\n");
+  result.Printf(" ---------- ----------- ---------- ----------- ----\n");
+  int printed = 0;
+  for (TypeDelta& delta : deltas) {
+    if (printed++ == output_limit) {
+      result.Printf(" ..........\n");
+      break;
+    }
+
+    uint64_t count = 0;
+    uint64_t size = 0;
+    if (delta.current != nullptr) {
+      count = delta.current->GetInstanceCount();
+      size = delta.current->GetTotalInstanceSize();
+    }
+    result.Printf(" %+10" PRId64 " %+11" PRId64 " %10" PRIu64 " %11" PRIu64
+                  " %s\n",
+                  delta.count_delta, delta.size_delta, count, size,
+                  delta.name.c_str());
+    if (delta.count_delta <= 0) continue;
+
+    std::string samples;
+    for (uint64_t addr : sample(delta, kSamples)) {
+      char buf[32];
+      snprintf(buf, sizeof(buf), " 0x%016" PRIx64, addr);
+      samples += buf;
+    }
+    // Under the name column
+    if (!samples.empty()) result.Printf("%47snew:%s\n", "", samples.c_str());
+  }
+}
+
+uint64_t TotalInstances(TypeRecordMap& records, uint64_t* size) {
+  uint64_t count = 0;
+  *size = 0;
+  for (auto& entry : records) {
+    count += entry.second->GetInstanceCount();
+    *size += entry.second->GetTotalInstanceSize();
+  }
+  return count;
+}
+
+}  // namespace
+
+
+HeapDiffCmd::~HeapDiffCmd() { ReleaseBaseline(); }
+
+
+void HeapDiffCmd::ReleaseBaseline() {
+  // The scan points into the LLV8, which loaded its constants through the
+  // target's symbol index.
+  baseline_llscan_.reset();
+  baseline_llv8_.reset();
+  if (baseline_target_.IsValid()) {
+    SymbolIndex::Release(baseline_target_);
+    SBDebugger d = baseline_target_.GetDebugger();
+    if (d.IsValid()) d.DeleteTarget(baseline_target_);
+  }
+  baseline_target_ = SBTarget();
+  baseline_core_.clear();
+  baseline_exe_.clear();
+}
+
+
+bool HeapDiffCmd::LoadBaseline(SBDebugger d, const char* core,
+                               const char* exe, SBCommandReturnObject& result) {
+  // Scanning a core takes a while, keep the last one around.
+  if (baseline_target_.IsValid() && baseline_core_ == core &&
+      baseline_exe_ == exe)
+    return true;
+
+  ReleaseBaseline();
+
+  // Creating a target selects it, the command keeps working on the current
+  // one.
+  SBTarget current = d.GetSelectedTarget();
+  baseline_target_ = d.CreateTarget(exe);
+  d.SetSelectedTarget(current);
+  if (!baseline_target_.IsValid()) {
+    result.SetError("Failed to create a target for the executable\n");
+    return false;
+  }
+
+  SBProcess process = baseline_target_.LoadCore(core);
+  if (!process.IsValid()) {
+    ReleaseBaseline();
+    result.SetError("Failed to load the core file\n");
+    return false;
+  }
+
+  // Its own LLV8, so the constants of both targets stay loaded.
+  baseline_llv8_.reset(new v8::LLV8());
+  baseline_llv8_->Load(baseline_target_);
+  baseline_llscan_.reset(new LLScan(baseline_llv8_.get()));
+  baseline_core_ = core;
+  baseline_exe_ = exe;
+  return true;
+}
+
+
+bool HeapDiffCmd::DoExecute(SBDebugger d, char** cmd,
+                            SBCommandReturnObject& result) {
+  SBTarget target = d.GetSelectedTarget();
+  if (!target.IsValid()) {
+    result.SetError("No valid process, please start something\n");
+    return false;
+  }
+
+  Printer::PrinterOptions printer_options;
+  char** args = ParsePrinterOptions(cmd, &printer_options);
+  int output_limit = printer_options.output_limit > 0
+                         ? printer_options.output_limit
+                         : kDefaultOutputLimit;
+  if (args == nullptr || args[0] == nullptr || args[1] == nullptr) {
+    result.SetError("USAGE: v8 heapdiff [flags] other-core other-exe\n");
+    return false;
+  }
+  const char* core = args[0];
+  const char* exe = args[1];
+
+  // Load V8 constants from postmortem data
+  llscan_->v8()->Load(target);
+
+  /* Ensure we have a map of objects. */
+  if (!llscan_->ScanHeapForObjects(target, result)) {
+    result.SetStatus(eReturnStatusFailed);
+    return false;
+  }
+
+  if (!LoadBaseline(d, core, exe, result)) {
+    result.SetStatus(eReturnStatusFailed);
+    return false;
+  }
+  if (!baseline_llscan_->ScanHeapForObjects(baseline_target_, result)) {
+    result.SetStatus(eReturnStatusFailed);
+    return false;
+  }
+
+  uint64_t baseline_size;
+  uint64_t current_size;
+  uint64_t baseline_count =
+      TotalInstances(baseline_llscan_->GetMapsToInstances(), &baseline_size);
+  uint64_t current_count =
+      TotalInstances(llscan_->GetMapsToInstances(), &current_size);
+  result.Printf("%" PRIu64 " objects (%" PRIu64 " bytes) in %s, %" PRIu64
+                " objects (%" PRIu64 " bytes) now: %+" PRId64
+                " objects, %+" PRId64 " bytes\n",
+                baseline_count, baseline_size, core, current_count,
+                current_size,
+                static_cast<int64_t>(current_count - baseline_count),
+                static_cast<int64_t>(current_size - baseline_size));
+
+  std::vector<TypeDelta> types =
+      DiffTypeRecords(baseline_llscan_->GetMapsToInstances(),
+                      llscan_->GetMapsToInstances());
+  PrintTypeDeltas(result, "Types", types, output_limit, NewTypeInstances);
+
+  std::vector<TypeDelta> sites =
+      DiffTypeRecords(baseline_llscan_->GetSitesToInstances(),
+                      llscan_->GetSitesToInstances());
+  LLScan* baseline = baseline_llscan_.get();
+  PrintTypeDeltas(result, "Sites", sites, output_limit,
+                  [&](const TypeDelta& delta, size_t count) {
+                    return NewSiteInstances(baseline, llscan_, delta, count);
+                  });
+
+  result.SetStatus(eReturnStatusSuccessFinishResult);
+  return true;
+}
+
+
+bool DuplicateStringsCmd::DoExecute(SBDebugger d, char** cmd,
+                                    SBCommandReturnObject& result) {
+  SBTarget target = d.GetSelectedTarget();
+  if (!target.IsValid()) {
+    result.SetError("No valid process, please start something\n");
+    return false;
+  }
+
+  Printer::PrinterOptions printer_options;
+  ParsePrinterOptions(cmd, &printer_options);
+  int output_limit = printer_options.output_limit > 0
+                         ? printer_options.output_limit
+                         : kDefaultOutputLimit;
+
+  // Load V8 constants from postmortem data
+  llscan_->v8()->Load(target);
+
+  /* Ensure we have a map of objects. */
+  if (!llscan_->ScanHeapForObjects(target, result)) {
+    result.SetStatus(eReturnStatusFailed);
+    return false;
+  }
+
+  TypeRecordMap::iterator strings_it =
+      llscan_->GetMapsToInstances().find("(String)");
+  if (strings_it == llscan_->GetMapsToInstances().end()) {
+    result.Printf("No strings found.\n");
+    result.SetStatus(eReturnStatusSuccessFinishResult);
+    return true;
+  }
+
+  // First pass: hash the contents of every string, keeping only a compact
+  // entry per distinct hash. Entries with the same hash but a different size
+  // are real collisions and are moved to the next slot.
+  std::unordered_map<uint64_t, HashEntry> hashes;
+  uint64_t total_strings = 0;
+  for (uint64_t addr : strings_it->second->GetInstances()) {
+    Error err;
+    v8::String str(llscan_->v8(), addr);
+    std::string value;
+    uint32_t size;
+    if (!LoadFlatString(str, value, size, err)) continue;
+
+    total_strings++;
+    uint64_t hash = HashString(value);
+    while (true) {
+      HashEntry hash_entry = {addr, 0, size};
+      auto entry = hashes.insert(std::make_pair(hash, hash_entry));
+      if (entry.first->second.size == size) {
+        entry.first->second.count++;
+        break;
+      }
+      hash++;
+    }
+  }
+
+  std::vector<DuplicateGroup> groups;
+  for (auto& entry : hashes) {
+    HashEntry& hash_entry = entry.second;
+    if (hash_entry.count < 2) continue;
+    DuplicateGroup group;
+    group.address = hash_entry.address;
+    group.size = hash_entry.size;
+    group.count = hash_entry.count;
+    groups.push_back(group);
+  }
+  hashes.clear();
+
+  auto duplicated_bytes = [](const DuplicateGroup& group) -> uint64_t {
+    return group.count > 1 ? (group.count - 1) * group.size : 0;
+  };
+  auto by_duplicated_bytes = [&](const DuplicateGroup& a,
+                                 const DuplicateGroup& b) {
+    if (duplicated_bytes(a) == duplicated_bytes(b)) {
+      return a.address < b.address;
+    }
+    return duplicated_bytes(a) > duplicated_bytes(b);
+  };
+
+  // Second pass: compare every group byte by byte, so neither the totals nor
+  // the reported groups include hash collisions. This also gives us their
+  // sample addresses.
+  ConfirmDuplicates(groups);
+  groups.erase(std::remove_if(groups.begin(), groups.end(),
+                              [](const DuplicateGroup& group) {
+                                return group.count < 2;
+                              }),
+               groups.end());
+
+  uint64_t total_groups = groups.size();
+  uint64_t total_duplicated_bytes = 0;
+  for (auto& group : groups) {
+    total_duplicated_bytes += duplicated_bytes(group);
+  }
+
+  if (groups.size() > static_cast<size_t>(output_limit)) {
+    std::partial_sort(groups.begin(), groups.begin() + output_limit,
+                      groups.end(), by_duplicated_bytes);
+    groups.resize(output_limit);
+  } else {
+    std::sort(groups.begin(), groups.end(), by_duplicated_bytes);
+  }
+
+  ReferrerCountMap referrers;
+  for (auto& group : groups) {
+    for (uint64_t sample : group.samples) referrers[sample] = 0;
+  }
+  CountReferrers(referrers);
+
+  Printer printer(llscan_->v8(), printer_options);
+
+  result.Printf("   Copies   Dup. Bytes       Size Value\n");
+  result.Printf(" -------- ------------ ---------- -----\n");
+  for (auto& group : groups) {
+    Error err;
+    v8::String str(llscan_->v8(), group.address);
+    result.Printf(" %8" PRId64 " %12" PRId64 " %10" PRIu32 " %s\n",
+                  group.count, duplicated_bytes(group), group.size,
+                  printer.Stringify(str, err).c_str());
+    for (uint64_t sample : group.samples) {
+      result.Printf("          0x%016" PRIx64 " (%" PRId64 " referrers)\n",
+                    sample, referrers[sample]);
+    }
+  }
+  result.Printf(" -------- ------------ ---------- -----\n");
+  result.Printf(" %" PRId64 " strings, %" PRId64
+                " duplicated values, %" PRId64 " duplicated bytes\n",
+                total_strings, total_groups, total_duplicated_bytes);
+
+  result.SetStatus(eReturnStatusSuccessFinishResult);
+  return true;
+}
+
+
+/* FNV-1a, we only need it to be fast and well distributed. */
+uint64_t DuplicateStringsCmd::HashString(const std::string& value) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (unsigned char c : value) {
+    hash ^= c;
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+
+/* Load the flattened contents of str. Thin strings and cons strings which
+ * were already flattened only forward to another string, which is scanned on
+ * its own, so they are skipped.
+ */
+bool DuplicateStringsCmd::LoadFlatString(v8::String& str, std::string& value,
+                                         uint32_t& size, Error& err) {
+  v8::LLV8* v8 = str.v8();
+
+  v8::CheckedType<int64_t> repr = str.Representation(err);
+  if (err.Fail() || !repr.Check()) return false;
+  if (*repr == v8->string()->kThinStringTag ||
+      *repr == v8->string()->kExternalStringTag) {
+    return false;
+  }
+
+  int64_t encoding = str.Encoding(err);
+  if (err.Fail()) return false;
+
+  v8::CheckedType<int32_t> length = str.Length(err);
+  if (err.Fail() || !length.Check()) return false;
+
+  if (*repr != v8->string()->kSeqStringTag && *length > kMaxFlattenLength) {
+    return false;
+  }
+  if (*repr == v8->string()->kConsStringTag) {
+    v8::ConsString cons(str);
+    v8::String second = cons.Second(err);
+    if (err.Fail()) return false;
+    v8::CheckedType<int32_t> second_length = second.Length(err);
+    if (err.Fail() || !second_length.Check()) return false;
+    if (*second_length == 0) return false;
+  }
+
+  size = *length;
+  if (encoding == v8->string()->kTwoByteStringTag) size *= 2;
+
+  value = str.ToString(err);
+  return err.Success();
+}
+
+
+void DuplicateStringsCmd::ConfirmDuplicates(
+    std::vector<DuplicateGroup>& groups) {
+  std::unordered_multimap<uint32_t, DuplicateGroup*> groups_by_size;
+  for (auto& group : groups) {
+    Error err;
+    v8::String str(llscan_->v8(), group.address);
+    uint32_t size;
+    LoadFlatString(str, group.value, size, err);
+    group.count = 0;
+    groups_by_size.emplace(group.size, &group);
+  }
+
+  TypeRecord* strings = llscan_->GetMapsToInstances().at("(String)");
+  for (uint64_t addr : strings->GetInstances()) {
+    Error err;
+    v8::String str(llscan_->v8(), addr);
+
+    // Cheap check first, most strings won't have the size of any group.
+    v8::CheckedType<int32_t> length = str.Length(err);
+    if (err.Fail() || !length.Check()) continue;
+    if (groups_by_size.count(*length) == 0 &&
+        groups_by_size.count(*length * 2) == 0) {
+      continue;
+    }
+
+    std::string value;
+    uint32_t size;
+    if (!LoadFlatString(str, value, size, err)) continue;
+
+    auto range = groups_by_size.equal_range(size);
+    for (auto it = range.first; it != range.second; ++it) {
+      DuplicateGroup* group = it->second;
+      if (group->value != value) continue;
+
+      group->count++;
+      if (group->samples.size() < kNumberOfSamples) {
+        group->samples.push_back(addr);
+      }
+      break;
+    }
+  }
+}
+
+
+void DuplicateStringsCmd::CountReferrers(ReferrerCountMap& referrers) {
+  if (referrers.empty()) return;
+
+  // Reuse the references from `v8 findrefs` if they were already collected,
+  // otherwise only count references to the sample strings.
+  if (llscan_->AreReferencesByValueLoaded()) {
+    for (auto& entry : referrers) {
+      entry.second = llscan_->GetReferencesByValue(entry.first)->size();
+    }
+    return;
+  }
+
+  ReferrerCounter counter(referrers);
+  FindReferencesCmd(llscan_).ScanForReferences(&counter);
+}
+
+
+void DuplicateStringsCmd::ReferrerCounter::CountReference(
+    uint64_t value, std::set<uint64_t>& already_counted) {
+  auto it = referrers_.find(value);
+  if (it == referrers_.end()) return;
+  if (!already_counted.insert(value).second) return;
+  it->second++;
+}
+
+
+void DuplicateStringsCmd::ReferrerCounter::ScanRefs(v8::JSObject& js_obj,
+                                                    Error& err) {
+  std::set<uint64_t> already_counted;
+
+  int64_t length = js_obj.GetArrayLength(err);
+  for (int64_t i = 0; i < length; ++i) {
+    v8::Value v = js_obj.GetArrayElement(i, err);
+
+    // Array is borked, or not array at all - skip it
+    if (!err.Success()) break;
+    CountReference(v.raw(), already_counted);
+  }
+
+  std::vector<std::pair<v8::Value, v8::Value>> entries = js_obj.Entries(err);
+  if (err.Fail()) {
+    return;
+  }
+  for (auto entry : entries) {
+    CountReference(entry.second.raw(), already_counted);
+  }
+}
+
+
+void DuplicateStringsCmd::ReferrerCounter::ScanRefs(v8::String& str,
+                                                    Error& err) {
+  std::set<uint64_t> already_counted;
+
+  v8::LLV8* v8 = str.v8();
+
+  v8::CheckedType<int64_t> repr = str.Representation(err);
+  RETURN_IF_INVALID(repr, );
+
+  // Strings only refer to other strings through their parts.
+  if (*repr == v8->string()->kSlicedStringTag) {
+    v8::SlicedString sliced_str(str);
+    v8::String parent = sliced_str.Parent(err);
+    if (err.Success()) CountReference(parent.raw(), already_counted);
+  } else if (*repr == v8->string()->kConsStringTag) {
+    v8::ConsString cons_str(str);
+    v8::String first = cons_str.First(err);
+    if (err.Success()) CountReference(first.raw(), already_counted);
+    v8::String second = cons_str.Second(err);
+    if (err.Success()) CountReference(second.raw(), already_counted);
+  } else if (*repr == v8->string()->kThinStringTag) {
+    v8::ThinString thin_str(str);
+    v8::String actual = thin_str.Actual(err);
+    if (err.Success()) CountReference(actual.raw(), already_counted);
+  }
+}
+
+
+FindJSObjectsVisitor::FindJSObjectsVisitor(SBTarget& target, LLScan* llscan)
+    : target_(target), llscan_(llscan) {
+  found_count_ = 0;
+  address_byte_size_ = target_.GetProcess().GetAddressByteSize();
+}
+
+
+/* Visit every address, a bit brute force but it works. */
+uint64_t FindJSObjectsVisitor::Visit(uint64_t location, uint64_t word) {
+  v8::Value v8_value(llscan_->v8(), word);
+
+  Error err;
+  // Test if this is SMI
+  // Skip inspecting things that look like Smi's, they aren't objects.
+  v8::Smi smi(v8_value);
+  if (smi.Check()) return address_byte_size_;
+
+  v8::HeapObject heap_object(v8_value);
+  if (!heap_object.Check()) return address_byte_size_;
+
+  v8::HeapObject map_object = heap_object.GetMap(err);
+  if (err.Fail() || !map_object.Check()) return address_byte_size_;
+
+  return VisitHeapObject<v8::layout::Dynamic>(heap_object,
+                                             v8::Map(map_object));
+}
+
+
+template <class Layout>
+inline uint64_t FindJSObjectsVisitor::VisitWord(uint64_t location,
+                                                uint64_t word) {
+  // Smis and the heap object tag share the low bits, so a single test
+  // discards both Smis and untagged words.
+  if (!v8::layout::IsHeapObject<Layout>(word)) return address_byte_size_;
+
+  Error err;
+  int64_t map_address =
+      llscan_->v8()->LoadField<Layout>(word, Layout::kMapOffset, err);
+  if (err.Fail() || !v8::layout::IsHeapObject<Layout>(map_address))
+    return address_byte_size_;
+
+  return VisitHeapObject<Layout>(v8::HeapObject(llscan_->v8(), word),
+                                 v8::Map(llscan_->v8(), map_address));
+}
+
+
+template <>
+inline uint64_t FindJSObjectsVisitor::VisitWord<v8::layout::Dynamic>(
+    uint64_t location, uint64_t word) {
+  return Visit(location, word);
+}
+
+
+template <class Layout>
+uint64_t FindJSObjectsVisitor::VisitHeapObject(v8::HeapObject heap_object,
+                                               v8::Map map) {
+  Error err;
+  uint64_t word = heap_object.raw();
+
+  auto cached = map_cache_.find(map.raw());
+  if (cached == map_cache_.end()) {
+    MapCacheEntry entry;
+    entry.Load(map, heap_object, llscan_->v8(), sites_, err);
+    if (err.Fail()) {
+      return address_byte_size_;
+    }
+    // Cache result
+    cached = map_cache_.emplace(map.raw(), entry).first;
+  }
+  MapCacheEntry& map_info = cached->second;
+
+  if (map_info.is_context) {
+    InsertOnContexts(word, err);
+    return address_byte_size_;
+  }
+
+  if (map_info.is_free_space) {
+    InsertOnFreeSpaces<Layout>(word, err);
+    return address_byte_size_;
+  }
+
+  if (map_info.is_array_buffer) {
+    InsertOnArrayBuffers(word, err);
+    return address_byte_size_;
+  }
+
+  if (map_info.is_code) {
+    llscan_->GetCodeMap()->AddCode(v8::Code(llscan_->v8(), word), err);
+    return address_byte_size_;
+  }
+
+  if (map_info.is_global) {
+    InsertOnGlobalObjects(word, err);
+    return address_byte_size_;
+  }
+
+  if (map_info.is_collection) {
+    llscan_->GetCollections()->insert(word);
+    return address_byte_size_;
+  }
+
+  // Promises are JSObjects, they are counted below too.
+  if (map_info.is_promise) llscan_->GetPromises()->insert(word);
+
+  if (map_info.is_js_function) {
+    llscan_->GetFunctions()->insert(word);
+    // Functions are still counted below if their code can't be loaded.
+    Error code_err;
+    llscan_->GetCodeMap()->AddFunction(v8::JSFunction(llscan_->v8(), word),
+                                       code_err);
+  }
+
+  if (!map_info.is_histogram) return address_byte_size_;
+
+  // Sites are summed from the Maps once the scan is done.
+  if (InsertOnMapsToInstances(word, map_info)) {
+    InsertOnMaps<Layout>(heap_object, map, map_info, err);
+    InsertOnHistograms<Layout>(heap_object, map_info, err);
+  }
+  InsertOnDetailedMapsToInstances(word, map_info);
+
+  if (err.Fail()) {
+    return address_byte_size_;
+  }
+
+  found_count_++;
+
+  /* Just advance one word.
+   * (Should advance by object size, assuming objects can't overlap!)
+   */
+  return address_byte_size_;
+}
+
+void FindJSObjectsVisitor::InsertOnContexts(uint64_t word, Error& err) {
+  ContextVector* contexts;
+  contexts = llscan_->GetContexts();
+  contexts->insert(word);
+}
+
+void FindJSObjectsVisitor::InsertOnArrayBuffers(uint64_t word, Error& err) {
+  ArrayBufferSet* array_buffers;
+  array_buffers = llscan_->GetArrayBuffers();
+  array_buffers->insert(word);
+}
+
+void FindJSObjectsVisitor::InsertOnGlobalObjects(uint64_t word, Error& err) {
+  GlobalObjectSet* global_objects;
+  global_objects = llscan_->GetGlobalObjects();
+  global_objects->insert(word);
+}
+
+template <class Layout>
+void FindJSObjectsVisitor::InsertOnFreeSpaces(uint64_t word, Error& err) {
+  // Free list entries are referenced from their list heads and neighbours,
+  // only count each of them once.
+  if (!free_spaces_.insert(word).second) return;
+
+  HeapPage* page = llscan_->GetHeapPage(word);
+  if (page == nullptr) return;
+
+  v8::LLV8* v8 = llscan_->v8();
+  int64_t size;
+  if (!v8->LoadSmiField<Layout>(word, v8->free_space()->kSizeOffset, &size,
+                                err)) {
+    return;
+  }
+
+  page->AddFreeSpace(size);
+}
+
+bool FindJSObjectsVisitor::InsertOnMapsToInstances(
+    uint64_t word, const MapCacheEntry& map_info) {
+  TypeRecord* t;
+
+  auto entry = std::make_pair(map_info.type_name, nullptr);
+  auto pp = &llscan_->GetMapsToInstances().insert(entry).first->second;
+  // No entry in the map, create a new one.
+  if (*pp == nullptr) *pp = new TypeRecord(map_info.type_name);
+  t = *pp;
+
+  if (!t->AddInstance(word, map_info.instance_size)) return false;
+  HeapPage* page = llscan_->GetHeapPage(word);
+  if (page != nullptr) page->AddLiveObject(map_info.instance_size);
+  return true;
+}
+
+template <class Layout>
+void FindJSObjectsVisitor::InsertOnMaps(v8::HeapObject heap_object,
+                                        v8::Map map, MapCacheEntry& map_info,
+                                        Error& err) {
+  // Filled in once per Map, from what MapCacheEntry::Load found.
+  if (map_info.record == nullptr) {
+    MapRecord& record = llscan_->GetMaps()[map.raw()];
+    record.site = map_info.site;
+    record.type_name = map_info.type_name;
+    record.root = map_info.root_map;
+    record.depth = map_info.transition_depth;
+    record.is_dictionary = map_info.is_dictionary;
+    map_info.record = &record;
+  }
+
+  MapRecord* record = map_info.record;
+  record->instance_count++;
+  record->instance_size += map_info.instance_size;
+  if (!record->is_dictionary) return;
+
+  // The cost of dictionary mode is mostly in the properties dictionary.
+  v8::LLV8* v8 = llscan_->v8();
+  int64_t properties = v8->LoadField<Layout>(
+      heap_object.raw(), v8->js_object()->kPropertiesOffset, err);
+  if (err.Fail()) return;
+  int64_t length;
+  if (!v8->LoadSmiField<Layout>(
+          properties, v8->fixed_array_base()->kLengthOffset, &length, err)) {
+    return;
+  }
+  record->dictionary_size +=
+      v8->fixed_array()->kDataOffset + length * address_byte_size_;
+}
+
+void FindJSObjectsVisitor::InsertOnDetailedMapsToInstances(
+    uint64_t word, const MapCacheEntry& map_info) {
+  DetailedTypeRecord* t;
+
+  auto type_name_with_properties = map_info.GetTypeNameWithProperties();
+
+  auto entry = std::make_pair(type_name_with_properties, nullptr);
+  auto pp = &llscan_->GetDetailedMapsToInstances().insert(entry).first->second;
+  // No entry in the map, create a new one.
+  if (*pp == nullptr) {
+    auto type_name_with_three_properties = map_info.GetTypeNameWithProperties(
+        MapCacheEntry::kDontShowArrayLength,
+        kNumberOfPropertiesForDetailedOutput);
+    *pp = new DetailedTypeRecord(type_name_with_three_properties,
+                                 map_info.own_descriptors_count_,
+                                 map_info.indexed_properties_count_);
+  }
+  t = *pp;
+  t->AddInstance(word, map_info.instance_size);
+}
+
+
+template <class Layout>
+void FindJSObjectsVisitor::InsertOnHistograms(v8::HeapObject heap_object,
+                                              const MapCacheEntry& map_info,
+                                              Error& err) {
+  if (map_info.is_string) {
+    v8::String str(heap_object);
+    v8::CheckedType<int32_t> length = str.Length(err);
+    if (err.Fail() || !length.Check()) return;
+    histograms_.string_lengths.Add(*length, *length);
+    return;
+  }
+
+  if (!map_info.is_js_array) return;
+
+  v8::LLV8* v8 = llscan_->v8();
+  int64_t length;
+  if (!v8->LoadSmiField<Layout>(heap_object.raw(),
+                                v8->js_array()->kLengthOffset, &length, err) ||
+      length < 0) {
+    return;
+  }
+  int64_t elements = v8->LoadField<Layout>(
+      heap_object.raw(), v8->js_object()->kElementsOffset, err);
+  if (err.Fail()) return;
+  int64_t capacity;
+  if (!v8->LoadSmiField<Layout>(elements, v8->fixed_array_base()->kLengthOffset,
+                                &capacity, err)) {
+    return;
+  }
+
+  v8::Map::ElementsStore store = map_info.elements_store;
+  if (store == v8::Map::kUnknownElements) {
+    v8::HeapObject elements_obj(v8, elements);
+    int64_t type = elements_obj.GetType(err);
+    if (err.Fail()) return;
+    if (v8->types()->kFixedDoubleArrayType.Check() &&
+        type == *v8->types()->kFixedDoubleArrayType) {
+      store = v8::Map::kDoubleElements;
+    } else if (type == v8->types()->kFixedArrayType) {
+      store = v8::Map::kTaggedElements;
+    }
+  }
+
+  // Dictionaries are laid out as a FixedArray too, but their capacity is
+  // in hash table slots, not elements.
+  int64_t element_size =
+      store == v8::Map::kDoubleElements ? sizeof(double) : address_byte_size_;
+  int64_t data_offset = v8->fixed_array()->kDataOffset;
+  histograms_.array_lengths.Add(
+      length, capacity > 0 ? data_offset + capacity * element_size : 0);
+  if (store != v8::Map::kTaggedElements && store != v8::Map::kDoubleElements)
+    return;
+  if (capacity >= length) {
+    histograms_.array_slack.Add(capacity - length,
+                                (capacity - length) * element_size);
+  }
+}
+
+
+bool FindJSObjectsVisitor::IsAHistogramType(v8::Map& map, Error& err) {
+  int64_t type = map.GetType(err);
+  if (err.Fail()) return false;
+
+  v8::LLV8* v8 = map.v8();
+  if (v8::JSObject::IsObjectType(v8, type)) return true;
+  if (type == v8->types()->kJSArrayType) return true;
+  if (type == v8->types()->kJSTypedArrayType) return true;
+  if (type < v8->types()->kFirstNonstringType) return true;
+  return false;
+}
+
+
+bool LLScan::ScanHeapForObjects(lldb::SBTarget target,
+                                lldb::SBCommandReturnObject& result,
+                                ScanProgress progress) {
+  /* Check the last scan is still valid - the process hasn't moved
+   * and we haven't changed target.
+   */
+
+  // Reload process anyway
+  process_ = target.GetProcess();
+
+  // Need to reload memory regions.
+  if (target_ != target) {
+    ClearMapsToInstances();
+    ClearReferences();
+    ClearHeapPages();
+    array_buffers_.clear();
+    functions_.clear();
+    global_objects_.clear();
+    collections_.clear();
+    promises_.clear();
+    target_ = target;
+  }
+
+  /* If we've reached here we have access to information about the valid memory
+   * regions in the process and can scan for objects.
+   */
+
+  /* Populate the map of objects. */
+  if (mapstoinstances_.empty()) {
+    FindJSObjectsVisitor v(target, this);
+
+    // Code objects found by the scan are added on top of the builtins. The
+    // live and free bytes of pages are counted from scratch too.
+    code_map_.Load(target);
+    code_map_.ClearCode();
+    ClearHeapPages();
+    if (!ScanMemoryRegions(v, progress)) {
+      // Don't leave a partial scan behind, the next one starts over.
+      ClearMapsToInstances();
+      ClearReferences();
+      ClearHeapPages();
+      code_map_.ClearCode();
+      array_buffers_.clear();
+      functions_.clear();
+      global_objects_.clear();
+      collections_.clear();
+      promises_.clear();
+      result.SetError("Heap scan cancelled\n");
+      return false;
+    }
+    histograms_.Merge(v.Histograms());
+    LoadSitesToInstances();
+  }
+
+  return true;
+}
+
+
+void LLScan::LoadSitesToInstances() {
+  for (auto& entry : maps_) {
+    const MapRecord& record = entry.second;
+    TypeRecord*& site = sitestoinstances_[record.site];
+    if (site == nullptr) site = new TypeRecord(record.site);
+    site->AddInstances(record.instance_count, record.instance_size);
+  }
 }
 
 std::string FindJSObjectsVisitor::MapCacheEntry::GetTypeNameWithProperties(
-    ShowArrayLength show_array_length, size_t max_properties) {
+    ShowArrayLength show_array_length, size_t max_properties) const {
   std::string type_name_with_properties(type_name);
 
   if (show_array_length == kShowArrayLength) {
@@ -1549,18 +3772,97 @@ std::string FindJSObjectsVisitor::MapCacheEntry::GetTypeNameWithProperties(
 
 bool FindJSObjectsVisitor::MapCacheEntry::Load(v8::Map map,
                                                v8::HeapObject heap_object,
-                                               v8::LLV8* llv8, Error& err) {
+                                               v8::LLV8* llv8,
+                                               SiteCache& sites, Error& err) {
   is_histogram = false;
+  is_free_space = false;
+  is_array_buffer = false;
+  is_code = false;
+  is_js_function = false;
+  is_global = false;
+  is_collection = false;
+  is_promise = false;
+  is_js_array = false;
+  is_string = false;
 
   is_context = v8::Context::IsContext(llv8, heap_object, err);
   if (err.Fail()) return false;
   if (is_context) return true;
 
+  int64_t type = map.GetType(err);
+  if (err.Fail()) return false;
+
+  is_free_space = type == llv8->types()->kFreeSpaceType;
+  if (is_free_space) return true;
+
+  is_array_buffer = type == llv8->types()->kJSArrayBufferType;
+  if (is_array_buffer) return true;
+
+  is_code = type == llv8->types()->kCodeType;
+  if (is_code) return true;
+
+  is_global = type == llv8->types()->kGlobalObjectType ||
+              type == llv8->types()->kGlobalProxyType;
+  if (is_global) return true;
+
+  is_collection = v8::JSCollection::IsCollectionType(llv8, type);
+  if (is_collection) return true;
+
+  is_js_function = type == llv8->types()->kJSFunctionType;
+  is_promise = v8::JSPromise::IsPromiseType(llv8, type);
+
   // Check type first
   is_histogram = FindJSObjectsVisitor::IsAHistogramType(map, err);
 
   // On success load type name
-  if (is_histogram) type_name = heap_object.GetTypeName(err);
+  if (is_histogram) {
+    type_name = heap_object.GetTypeName(err);
+    if (err.Fail()) return false;
+    instance_size = map.InstanceSize(err);
+    if (err.Fail()) return false;
+  }
+  is_js_array = is_histogram && type == llv8->types()->kJSArrayType;
+  if (is_js_array) {
+    elements_store = map.GetElementsStore(err);
+    if (err.Fail()) return false;
+  }
+  is_string = is_histogram && type < llv8->types()->kFirstNonstringType;
+
+  // Root of the transition tree, and where its constructor is defined,
+  // e.g. "Foo at lib/foo.js:12:3". Maps without a constructor in a script
+  // (strings, object literals, builtins) are grouped by type name.
+  if (is_histogram) {
+    site = type_name;
+    root_map = map.raw();
+    transition_depth = 0;
+    Error site_err;
+    is_dictionary = map.IsDictionary(site_err);
+    v8::HeapObject constructor = map.MaybeConstructor(site_err);
+    while (site_err.Success() && constructor.Check() &&
+           constructor.GetType(site_err) == llv8->types()->kMapType &&
+           transition_depth < kMaxTransitionDepth) {
+      root_map = constructor.raw();
+      transition_depth++;
+      v8::Map parent(constructor);
+      constructor = parent.MaybeConstructor(site_err);
+    }
+    if (site_err.Success() && constructor.Check() &&
+        constructor.GetType(site_err) == llv8->types()->kJSFunctionType) {
+      auto cached = sites.find(constructor.raw());
+      if (cached != sites.end()) {
+        site = cached->second;
+      } else {
+        v8::JSFunction fn(constructor);
+        v8::SharedFunctionInfo info = fn.Info(site_err);
+        std::string postfix = info.GetPostfix(site_err);
+        if (site_err.Success() && !postfix.empty() &&
+            postfix != "(no script)")
+          site = info.ProperName(site_err) + " at " + postfix;
+        if (site_err.Fail()) site = type_name;
+        sites.emplace(constructor.raw(), site);
+      }
+    }
+  }
 
   v8::HeapObject descriptors_obj = map.InstanceDescriptors(err);
   RETURN_IF_INVALID(descriptors_obj, false);
@@ -1569,7 +3871,6 @@ bool FindJSObjectsVisitor::MapCacheEntry::Load(v8::Map map,
   own_descriptors_count_ = map.NumberOfOwnDescriptors(err);
   if (err.Fail()) return false;
 
-  int64_t type = map.GetType(err);
   indexed_properties_count_ = 0;
   if (v8::JSObject::IsObjectType(llv8, type) ||
       (type == llv8->types()->kJSArrayType)) {
@@ -1596,7 +3897,22 @@ inline static ByteOrder GetHostByteOrder() {
   return u.b == 1 ? ByteOrder::eByteOrderBig : ByteOrder::eByteOrderLittle;
 }
 
-void LLScan::ScanMemoryRegions(FindJSObjectsVisitor& v) {
+bool LLScan::ScanMemoryRegions(FindJSObjectsVisitor& v,
+                               ScanProgress& progress) {
+  // Pick the scan loop once, rather than checking the layout for every word.
+  switch (llv8_->layout()) {
+    case v8::layout::kTagged64:
+      return ScanMemoryRegions<v8::layout::Tagged64>(v, progress);
+    case v8::layout::kTagged32:
+      return ScanMemoryRegions<v8::layout::Tagged32>(v, progress);
+    default:
+      return ScanMemoryRegions<v8::layout::Dynamic>(v, progress);
+  }
+}
+
+template <class Layout>
+bool LLScan::ScanMemoryRegions(FindJSObjectsVisitor& v,
+                               ScanProgress& progress) {
   const uint64_t addr_size = process_.GetAddressByteSize();
   bool swap_bytes = process_.GetByteOrder() != GetHostByteOrder();
 
@@ -1607,7 +3923,18 @@ void LLScan::ScanMemoryRegions(FindJSObjectsVisitor& v) {
   lldb::SBMemoryRegionInfoList memory_regions = process_.GetMemoryRegions();
   lldb::SBMemoryRegionInfo region_info;
 
-  for (uint32_t i = 0; i < memory_regions.GetSize(); ++i) {
+  uint64_t total = 0;
+  uint64_t scanned = 0;
+  if (progress) {
+    for (uint32_t i = 0; i < memory_regions.GetSize(); ++i) {
+      memory_regions.GetMemoryRegionAtIndex(i, region_info);
+      if (!region_info.IsWritable()) continue;
+      total += region_info.GetRegionEnd() - region_info.GetRegionBase();
+    }
+  }
+
+  bool cancelled = false;
+  for (uint32_t i = 0; i < memory_regions.GetSize() && !cancelled; ++i) {
     memory_regions.GetMemoryRegionAtIndex(i, region_info);
 
     if (!region_info.IsWritable()) {
@@ -1652,7 +3979,7 @@ void LLScan::ScanMemoryRegions(FindJSObjectsVisitor& v) {
           break;
         }
 
-        increment = v.Visit(j + searchAddress, value);
+        increment = v.VisitWord<Layout>(j + searchAddress, value);
         if (increment == 0) break;
 
         j += static_cast<size_t>(increment);
@@ -1661,12 +3988,96 @@ void LLScan::ScanMemoryRegions(FindJSObjectsVisitor& v) {
       if (increment == 0) {
         break;
       }
+
+      scanned += loaded;
+      if (progress && !progress(scanned, total)) {
+        cancelled = true;
+        break;
+      }
     }
   }
 
   delete[] block;
+  return !cancelled;
+}
+
+HeapPage* LLScan::GetHeapPage(uint64_t address) {
+  v8::MemoryChunk chunk = v8::MemoryChunk::FromAddress(llv8_, address);
+
+  auto entry = heap_pages_.insert(std::make_pair(chunk.raw(), nullptr));
+  // Load each page header only once, even if it isn't a valid page.
+  if (entry.second) {
+    Error err;
+    entry.first->second = HeapPage::Load(chunk, err);
+  }
+  return entry.first->second;
+}
+
+
+HeapPage* HeapPage::Load(v8::MemoryChunk chunk, Error& err) {
+  int64_t size = chunk.Size(err);
+  if (err.Fail()) return nullptr;
+
+  int64_t flags = chunk.Flags(err);
+  if (err.Fail()) return nullptr;
+
+  // Words which look like heap pointers can point anywhere, make sure this
+  // really is the header of a regular page or of a (sane) large object chunk.
+  if (!chunk.IsRegularPage(size) &&
+      !(chunk.IsLargePage(size) && (size >> 32) == 0)) {
+    return nullptr;
+  }
+
+  Space space = kOldSpace;
+  if (chunk.IsLargePage(size)) {
+    space = kLargeObjectSpace;
+  } else if (chunk.InNewSpace(flags)) {
+    space = kNewSpace;
+  } else if (chunk.IsExecutable(flags)) {
+    space = kCodeSpace;
+  }
+
+  return new HeapPage(chunk.raw(), size, space);
+}
+
+
+void LLScan::GetHeapSpaceTotals(HeapSpaceTotals* totals) {
+  for (auto entry : heap_pages_) {
+    HeapPage* page = entry.second;
+    if (page == nullptr) continue;
+
+    HeapSpaceTotals& space = totals[page->GetSpace()];
+    space.pages++;
+    space.committed += page->GetSize();
+    space.live += page->GetLiveBytes();
+    space.free += page->GetFreeBytes();
+  }
+}
+
+
+const char* HeapPage::SpaceName(Space space) {
+  switch (space) {
+    case kNewSpace:
+      return "new";
+    case kOldSpace:
+      return "old";
+    case kCodeSpace:
+      return "code";
+    case kLargeObjectSpace:
+      return "large-object";
+    default:
+      return "unknown";
+  }
+}
+
+
+LLScan::~LLScan() {
+  ClearMapsToInstances();
+  ClearReferences();
+  ClearHeapPages();
 }
 
+
 void LLScan::ClearMapsToInstances() {
   TypeRecord* t;
   for (auto entry : mapstoinstances_) {
@@ -1674,9 +4085,88 @@ void LLScan::ClearMapsToInstances() {
     delete t;
   }
   mapstoinstances_.clear();
+
+  for (auto entry : detailedmapstoinstances_) delete entry.second;
+  detailedmapstoinstances_.clear();
+
+  for (auto entry : sitestoinstances_) delete entry.second;
+  sitestoinstances_.clear();
+  maps_.clear();
+  histograms_.Clear();
+}
+
+
+void LengthHistogram::Merge(const LengthHistogram& other) {
+  for (int i = 0; i < kBuckets; i++) {
+    counts_[i] += other.counts_[i];
+    sizes_[i] += other.sizes_[i];
+  }
+}
+
+
+void LengthHistogram::Clear() {
+  for (int i = 0; i < kBuckets; i++) {
+    counts_[i] = 0;
+    sizes_[i] = 0;
+  }
+}
+
+
+void LengthHistogram::Print(lldb::SBCommandReturnObject& result,
+                            const char* title, const char* size_name) const {
+  uint64_t total = 0;
+  for (int i = 0; i < kBuckets; i++) total += counts_[i];
+
+  result.Printf("%s:\n", title);
+  result.Printf("                  Range      Count       %%  %12s\n",
+                size_name);
+  result.Printf(" ---------------------- ---------- ------- ------------\n");
+  uint64_t low = 0;
+  uint64_t high = 0;
+  for (int i = 0; i < kBuckets; i++) {
+    if (counts_[i] != 0) {
+      char range[32];
+      if (i == 0)
+        snprintf(range, sizeof(range), "0");
+      else if (i == kBuckets - 1)
+        snprintf(range, sizeof(range), "%" PRIu64 "+", low);
+      else
+        snprintf(range, sizeof(range), "%" PRIu64 " - %" PRIu64, low, high);
+      result.Printf(" %22s %10" PRIu64 " %6.2f%% %12" PRIu64 "\n", range,
+                    counts_[i], 100.0 * counts_[i] / total, sizes_[i]);
+    }
+    low = high + 1;
+    high = high == 0 ? 8 : high * 8;
+  }
+}
+
+ReferencesVector* LLScan::GetContextsByValue(uint64_t address) {
+  if (!contexts_by_value_loaded_) {
+    for (uint64_t ctx : contexts_) {
+      Error err;
+      v8::Context c(llv8_, ctx);
+      v8::Context::Locals locals(&c, err);
+      // If we can't read locals in this context, just go to the next.
+      if (err.Fail()) continue;
+
+      std::set<uint64_t> already_saved;
+      for (v8::Context::Locals::Iterator it = locals.begin();
+           it != locals.end(); it++) {
+        uint64_t local = (*it).raw();
+        if (already_saved.insert(local).second)
+          contexts_by_value_[local].push_back(ctx);
+      }
+    }
+    contexts_by_value_loaded_ = true;
+  }
+
+  return &contexts_by_value_[address];
 }
 
 void LLScan::ClearReferences() {
+  contexts_by_value_.clear();
+  contexts_by_value_loaded_ = false;
+
   ReferencesVector* references;
 
   for (auto entry : references_by_value_) {
@@ -1697,4 +4187,11 @@ void LLScan::ClearReferences() {
   }
   references_by_string_.clear();
 }
+
+void LLScan::ClearHeapPages() {
+  for (auto entry : heap_pages_) {
+    delete entry.second;
+  }
+  heap_pages_.clear();
+}
 }  // namespace llnode
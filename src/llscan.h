@@ -2,8 +2,11 @@
 #define SRC_LLSCAN_H_
 
 #include <lldb/API/LLDB.h>
+#include <functional>
 #include <map>
+#include <memory>
 #include <set>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "src/error.h"
@@ -15,9 +18,16 @@ namespace llnode {
 class LLScan;
 
 typedef std::vector<uint64_t> ReferencesVector;
+typedef std::unordered_set<uint64_t> ReferencesSet;
 typedef std::unordered_set<uint64_t> ContextVector;
+typedef std::unordered_set<uint64_t> ArrayBufferSet;
+typedef std::unordered_set<uint64_t> FunctionSet;
+typedef std::unordered_set<uint64_t> GlobalObjectSet;
+typedef std::unordered_set<uint64_t> CollectionSet;
+typedef std::unordered_set<uint64_t> PromiseSet;
 
 typedef std::map<uint64_t, ReferencesVector*> ReferencesByValueMap;
+typedef std::unordered_map<uint64_t, ReferencesVector> ContextsByValueMap;
 typedef std::map<std::string, ReferencesVector*> ReferencesByPropertyMap;
 typedef std::map<std::string, ReferencesVector*> ReferencesByStringMap;
 
@@ -44,8 +54,18 @@ class FindObjectsCmd : public CommandBase {
 
   void SimpleOutput(lldb::SBCommandReturnObject& result);
   void DetailedOutput(lldb::SBCommandReturnObject& result);
+  void SiteOutput(lldb::SBCommandReturnObject& result);
+  void HistogramsOutput(lldb::SBCommandReturnObject& result);
 
  private:
+  struct Options {
+    bool detailed = false;
+    bool by_site = false;
+    bool histograms = false;
+  };
+
+  static void ParseOptions(char** cmd, Options* options);
+
   LLScan* llscan_;
 };
 
@@ -76,15 +96,212 @@ class NodeInfoCmd : public CommandBase {
   LLScan* llscan_;
 };
 
+class HeapSpacesCmd : public CommandBase {
+ public:
+  HeapSpacesCmd(LLScan* llscan) : llscan_(llscan) {}
+  ~HeapSpacesCmd() override {}
+
+  bool DoExecute(lldb::SBDebugger d, char** cmd,
+                 lldb::SBCommandReturnObject& result) override;
+
+ private:
+  LLScan* llscan_;
+};
+
+class ArrayBuffersCmd : public CommandBase {
+ public:
+  ArrayBuffersCmd(LLScan* llscan) : llscan_(llscan) {}
+  ~ArrayBuffersCmd() override {}
+
+  bool DoExecute(lldb::SBDebugger d, char** cmd,
+                 lldb::SBCommandReturnObject& result) override;
+
+ private:
+  static const int kDefaultOutputLimit = 10;
+
+  struct BufferInfo {
+    uint64_t address;
+    uint64_t backing_store;
+    uint64_t byte_length;
+    uint64_t view_count;
+    uint64_t sample_view;
+  };
+
+  LLScan* llscan_;
+};
+
+class TimersCmd : public CommandBase {
+ public:
+  TimersCmd(LLScan* llscan) : llscan_(llscan) {}
+  ~TimersCmd() override {}
+
+  bool DoExecute(lldb::SBDebugger d, char** cmd,
+                 lldb::SBCommandReturnObject& result) override;
+
+ private:
+  static const int kDefaultOutputLimit = 10;
+
+  // Timeouts sharing a duration, node keeps one list per duration.
+  struct TimerGroup {
+    uint64_t count = 0;
+    uint64_t repeating = 0;
+    double first_expiry = 0;
+    uint64_t first_timer = 0;
+    std::map<std::string, uint64_t> callbacks;
+  };
+
+  // Smi or HeapNumber, other values (e.g. null) are not numbers.
+  static bool GetNumber(v8::Value value, double* number);
+
+  LLScan* llscan_;
+};
+
+class ContextsCmd : public CommandBase {
+ public:
+  ContextsCmd(LLScan* llscan) : llscan_(llscan) {}
+  ~ContextsCmd() override {}
+
+  bool DoExecute(lldb::SBDebugger d, char** cmd,
+                 lldb::SBCommandReturnObject& result) override;
+
+ private:
+  static const int kDefaultOutputLimit = 20;
+
+  char** ParseOptions(char** cmd, int* count);
+
+  // Contexts sharing a ScopeInfo, i.e. created by calls of one function.
+  struct ContextGroup {
+    std::string function_name;
+    uint64_t count = 0;
+    uint64_t slots = 0;
+    uint64_t bytes = 0;
+    uint64_t largest_size = 0;
+    uint64_t largest_value = 0;
+    std::string largest_name;
+  };
+
+  // Shallow size of value, 0 for Smis and values which can't be read.
+  static uint64_t ValueSize(v8::Value value);
+
+  LLScan* llscan_;
+};
+
+class CollectionsCmd : public CommandBase {
+ public:
+  CollectionsCmd(LLScan* llscan) : llscan_(llscan) {}
+  ~CollectionsCmd() override {}
+
+  bool DoExecute(lldb::SBDebugger d, char** cmd,
+                 lldb::SBCommandReturnObject& result) override;
+
+ private:
+  static const int kDefaultOutputLimit = 20;
+
+  struct CollectionInfo {
+    uint64_t address;
+    v8::JSCollection::Kind kind;
+    int64_t size;
+    int64_t table_size;
+  };
+
+  LLScan* llscan_;
+};
+
+class PromisesCmd : public CommandBase {
+ public:
+  PromisesCmd(LLScan* llscan) : llscan_(llscan) {}
+  ~PromisesCmd() override {}
+
+  bool DoExecute(lldb::SBDebugger d, char** cmd,
+                 lldb::SBCommandReturnObject& result) override;
+
+ private:
+  static const int kDefaultOutputLimit = 20;
+
+  // A pending promise and the pending promises which wait on it.
+  struct PendingPromise {
+    std::vector<uint64_t> next;
+    bool has_previous = false;
+    // Longest chain starting here, and where it ends.
+    int64_t chain_length = 0;
+    uint64_t chain_tail = 0;
+    std::string tail_handler;
+  };
+
+  static std::string HandlerName(v8::JSPromise::Reaction& reaction,
+                                 Error& err);
+
+  LLScan* llscan_;
+};
+
+class MapsCmd : public CommandBase {
+ public:
+  MapsCmd(LLScan* llscan) : llscan_(llscan) {}
+  ~MapsCmd() override {}
+
+  bool DoExecute(lldb::SBDebugger d, char** cmd,
+                 lldb::SBCommandReturnObject& result) override;
+
+ private:
+  static const int kDefaultOutputLimit = 20;
+
+  // Maps grouped by constructor or by transition tree.
+  struct MapGroup {
+    std::string site;
+    uint64_t root = 0;
+    int64_t depth = 0;
+    uint64_t maps = 0;
+    uint64_t instances = 0;
+    uint64_t dictionary_maps = 0;
+    uint64_t dictionary_instances = 0;
+    uint64_t dictionary_size = 0;
+  };
+
+  LLScan* llscan_;
+};
+
+class HeapDiffCmd : public CommandBase {
+ public:
+  HeapDiffCmd(LLScan* llscan) : llscan_(llscan) {}
+  ~HeapDiffCmd() override;
+
+  bool DoExecute(lldb::SBDebugger d, char** cmd,
+                 lldb::SBCommandReturnObject& result) override;
+
+ private:
+  static const int kDefaultOutputLimit = 20;
+
+  bool LoadBaseline(lldb::SBDebugger d, const char* core, const char* exe,
+                    lldb::SBCommandReturnObject& result);
+  // Deletes the baseline target and everything loaded from it.
+  void ReleaseBaseline();
+
+  LLScan* llscan_;
+
+  // The other core, kept with its scan until another one is requested.
+  std::string baseline_core_;
+  std::string baseline_exe_;
+  lldb::SBTarget baseline_target_;
+  std::unique_ptr<v8::LLV8> baseline_llv8_;
+  std::unique_ptr<LLScan> baseline_llscan_;
+};
+
 class ScanOptions {
  public:
   // Defines what are we looking for
   enum ScanType { kFieldValue, kPropertyName, kStringValue, kBadOption };
 
-  ScanOptions() : scan_type(ScanType::kFieldValue), recursive_scan(false) {}
+  ScanOptions()
+      : scan_type(ScanType::kFieldValue),
+        recursive_scan(false),
+        max_depth(0),
+        max_nodes(0) {}
 
   ScanType scan_type;
   bool recursive_scan;
+  // Limits of the recursive scan, 0 means unlimited.
+  int max_depth;
+  uint64_t max_nodes;
 };
 
 class FindReferencesCmd : public CommandBase {
@@ -117,7 +334,7 @@ class FindReferencesCmd : public CommandBase {
     virtual void PrintContextRefs(lldb::SBCommandReturnObject& result,
                                   Error& err, FindReferencesCmd* cli_cmd_,
                                   ScanOptions* options,
-                                  ReferencesVector* already_visited_references,
+                                  ReferencesSet* already_visited_references,
                                   int level = 0) {}
 
     std::string GetPropertyReferenceString(int level = 0);
@@ -127,14 +344,14 @@ class FindReferencesCmd : public CommandBase {
   void PrintReferences(lldb::SBCommandReturnObject& result,
                        ReferencesVector* references, ObjectScanner* scanner,
                        ScanOptions* options,
-                       ReferencesVector* already_visited_references,
+                       ReferencesSet* already_visited_references,
                        int level = 0);
 
   void ScanForReferences(ObjectScanner* scanner);
 
   void PrintRecursiveReferences(lldb::SBCommandReturnObject& result,
                                 ScanOptions* options,
-                                ReferencesVector* visited_references,
+                                ReferencesSet* visited_references,
                                 uint64_t address, int level);
 
   class ReferenceScanner : public ObjectScanner {
@@ -156,7 +373,7 @@ class FindReferencesCmd : public CommandBase {
 
     void PrintContextRefs(lldb::SBCommandReturnObject& result, Error& err,
                           FindReferencesCmd* cli_cmd_, ScanOptions* options,
-                          ReferencesVector* already_visited_references,
+                          ReferencesSet* already_visited_references,
                           int level = 0) override;
 
    private:
@@ -215,6 +432,99 @@ class FindReferencesCmd : public CommandBase {
   LLScan* llscan_;  // FindReferencesCmd::llscan_
 };
 
+class RetainersCmd : public CommandBase {
+ public:
+  RetainersCmd(LLScan* llscan) : llscan_(llscan) {}
+  ~RetainersCmd() override {}
+
+  bool DoExecute(lldb::SBDebugger d, char** cmd,
+                 lldb::SBCommandReturnObject& result) override;
+
+ private:
+  static const int kDefaultPathCount = 5;
+  static const int kDefaultDepth = 20;
+  static const int kDefaultTimeout = 30;
+  // Bytes read above the stack pointer of each thread.
+  static const uint64_t kMaxStackSize = 1024 * 1024;
+
+  struct StackSlot {
+    uint64_t address;
+    uint32_t thread;
+  };
+
+  typedef std::unordered_map<uint64_t, ReferencesVector> ReferrerMap;
+
+  char** ParseOptions(char** cmd, int* count, int* depth, int* timeout);
+  // Holders neither the reference scan nor LLScan::GetContextsByValue()
+  // see: contexts through their previous context, functions through their
+  // context and globals through their properties.
+  void LoadReferrers();
+  void LoadStackSlots(lldb::SBProcess process);
+  // Empty if address isn't a root.
+  std::string RootName(uint64_t address);
+  std::string EdgeName(uint64_t holder, uint64_t value);
+
+  LLScan* llscan_;
+  ReferrerMap referrers_;
+  std::unordered_map<uint64_t, StackSlot> stack_slots_;
+};
+
+class DuplicateStringsCmd : public CommandBase {
+ public:
+  DuplicateStringsCmd(LLScan* llscan) : llscan_(llscan) {}
+  ~DuplicateStringsCmd() override {}
+
+  bool DoExecute(lldb::SBDebugger d, char** cmd,
+                 lldb::SBCommandReturnObject& result) override;
+
+ private:
+  static const size_t kNumberOfSamples = 3;
+  static const int kDefaultOutputLimit = 20;
+  // Longer cons and sliced strings are not flattened, walking their trees
+  // would dominate the scan.
+  static const int32_t kMaxFlattenLength = 1 << 16;
+
+  // One entry per distinct string hash. Only the first copy is remembered
+  // so that memory stays bounded on heaps with millions of strings; the
+  // copies are confirmed against it before reporting.
+  struct HashEntry {
+    uint64_t address;
+    uint32_t count;
+    uint32_t size;
+  };
+
+  struct DuplicateGroup {
+    uint64_t address;
+    uint32_t size;
+    uint64_t count;
+    std::string value;
+    std::vector<uint64_t> samples;
+  };
+
+  typedef std::unordered_map<uint64_t, uint64_t> ReferrerCountMap;
+
+  class ReferrerCounter : public FindReferencesCmd::ObjectScanner {
+   public:
+    ReferrerCounter(ReferrerCountMap& referrers) : referrers_(referrers) {}
+
+    void ScanRefs(v8::JSObject& js_obj, Error& err) override;
+    void ScanRefs(v8::String& str, Error& err) override;
+
+   private:
+    void CountReference(uint64_t value, std::set<uint64_t>& already_counted);
+
+    ReferrerCountMap& referrers_;
+  };
+
+  static uint64_t HashString(const std::string& value);
+  bool LoadFlatString(v8::String& str, std::string& value, uint32_t& size,
+                      Error& err);
+  void ConfirmDuplicates(std::vector<DuplicateGroup>& groups);
+  void CountReferrers(ReferrerCountMap& referrers);
+
+  LLScan* llscan_;
+};
+
 class MemoryVisitor {
  public:
   virtual ~MemoryVisitor() {}
@@ -226,7 +536,7 @@ class DetailedTypeRecord;
 
 class TypeRecord {
  public:
-  TypeRecord(std::string& type_name)
+  TypeRecord(const std::string& type_name)
       : type_name_(type_name), instance_count_(0), total_instance_size_(0) {}
 
   inline std::string& GetTypeName() { return type_name_; };
@@ -234,14 +544,21 @@ class TypeRecord {
   inline uint64_t GetTotalInstanceSize() { return total_instance_size_; };
   inline std::unordered_set<uint64_t>& GetInstances() { return instances_; };
 
-  inline void AddInstance(uint64_t address, uint64_t size) {
+  inline bool AddInstance(uint64_t address, uint64_t size) {
     auto result = instances_.insert(address);
     if (result.second) {
       instance_count_++;
       total_instance_size_ += size;
     }
+    return result.second;
   };
 
+  // Counted without their addresses, e.g. summed from MapRecords.
+  inline void AddInstances(uint64_t count, uint64_t size) {
+    instance_count_ += count;
+    total_instance_size_ += size;
+  }
+
   /* Sort records by instance count, use the other fields as tie breakers
    * to give consistent ordering.
    */
@@ -285,6 +602,137 @@ class DetailedTypeRecord : public TypeRecord {
 typedef std::map<std::string, TypeRecord*> TypeRecordMap;
 typedef std::map<std::string, DetailedTypeRecord*> DetailedTypeRecordMap;
 
+/* A Map used by the objects found while scanning, kept once the scan is
+ * done to report hidden class churn.
+ */
+struct MapRecord {
+  // Constructor and its source location, as in findjsobjects --by-site
+  std::string site;
+  // Key of the TypeRecord holding the addresses of the instances
+  std::string type_name;
+  // Root of the transition tree and number of transitions from it
+  uint64_t root = 0;
+  int64_t depth = 0;
+  bool is_dictionary = false;
+
+  uint64_t instance_count = 0;
+  uint64_t instance_size = 0;
+  // Backing stores of dictionary mode instances
+  uint64_t dictionary_size = 0;
+};
+
+typedef std::unordered_map<uint64_t, MapRecord> MapRecordMap;
+
+/* Counts of values in buckets growing by a factor of 8: 0, 1-8, 9-64, ...
+ * Each bucket also sums a size given with the value (e.g. bytes).
+ */
+class LengthHistogram {
+ public:
+  static const int kBuckets = 12;
+
+  LengthHistogram() { Clear(); }
+
+  inline void Add(uint64_t value, uint64_t size) {
+    int bucket = 0;
+    for (uint64_t limit = 0; value > limit && bucket < kBuckets - 1;
+         bucket++)
+      limit = limit == 0 ? 8 : limit * 8;
+    counts_[bucket]++;
+    sizes_[bucket] += size;
+  }
+
+  void Merge(const LengthHistogram& other);
+  void Clear();
+
+  void Print(lldb::SBCommandReturnObject& result, const char* title,
+             const char* size_name) const;
+
+ private:
+  uint64_t counts_[kBuckets];
+  uint64_t sizes_[kBuckets];
+};
+
+/* Distributions gathered while scanning. Each visitor counts on its own and
+ * the counts are merged into LLScan once its scan is done.
+ */
+struct ScanHistograms {
+  // Number of elements of JSArrays, with the bytes of their backing stores
+  LengthHistogram array_lengths;
+  // Capacity of the backing store over the length, with the bytes wasted
+  LengthHistogram array_slack;
+  // Characters in strings
+  LengthHistogram string_lengths;
+
+  void Merge(const ScanHistograms& other) {
+    array_lengths.Merge(other.array_lengths);
+    array_slack.Merge(other.array_slack);
+    string_lengths.Merge(other.string_lengths);
+  }
+  void Clear() {
+    array_lengths.Clear();
+    array_slack.Clear();
+    string_lengths.Clear();
+  }
+};
+
+/* A V8 heap page found while scanning. V8 doesn't expose its page lists
+ * to postmortem metadata, so pages are discovered from the objects the scan
+ * visits and classified using the MemoryChunk header.
+ */
+class HeapPage {
+ public:
+  enum Space {
+    kNewSpace,
+    kOldSpace,
+    kCodeSpace,
+    kLargeObjectSpace,
+    kNumberOfSpaces
+  };
+
+  HeapPage(uint64_t address, uint64_t size, Space space)
+      : address_(address),
+        size_(size),
+        space_(space),
+        live_objects_(0),
+        live_bytes_(0),
+        free_bytes_(0) {}
+
+  static HeapPage* Load(v8::MemoryChunk chunk, Error& err);
+  static const char* SpaceName(Space space);
+
+  inline uint64_t GetAddress() { return address_; };
+  inline uint64_t GetSize() { return size_; };
+  inline Space GetSpace() { return space_; };
+  inline uint64_t GetLiveObjects() { return live_objects_; };
+  inline uint64_t GetLiveBytes() { return live_bytes_; };
+  inline uint64_t GetFreeBytes() { return free_bytes_; };
+
+  inline void AddLiveObject(uint64_t size) {
+    live_objects_++;
+    live_bytes_ += size;
+  };
+  inline void AddFreeSpace(uint64_t size) { free_bytes_ += size; };
+
+ private:
+  uint64_t address_;
+  uint64_t size_;
+  Space space_;
+  uint64_t live_objects_;
+  uint64_t live_bytes_;
+  uint64_t free_bytes_;
+};
+
+// Page start address -> page, nullptr if the address isn't on a V8 page.
+typedef std::unordered_map<uint64_t, HeapPage*> HeapPageMap;
+
+// Pages found by the scan in one space, as printed by `v8 heapspaces`.
+struct HeapSpaceTotals {
+  uint64_t pages = 0;
+  uint64_t committed = 0;
+  uint64_t live = 0;
+  uint64_t free = 0;
+};
+
 class FindJSObjectsVisitor : MemoryVisitor {
  public:
   FindJSObjectsVisitor(lldb::SBTarget& target, LLScan* llscan);
@@ -292,18 +740,53 @@ class FindJSObjectsVisitor : MemoryVisitor {
 
   uint64_t Visit(uint64_t location, uint64_t word);
 
+  // Same as Visit(), with the tag checks and the map load specialised for
+  // one of the layouts from llv8-layout.h.
+  template <class Layout>
+  inline uint64_t VisitWord(uint64_t location, uint64_t word);
+
   uint32_t FoundCount() { return found_count_; }
+  const ScanHistograms& Histograms() const { return histograms_; }
 
  private:
   // TODO (mmarchini): this could be an option for findjsobjects
   static const size_t kNumberOfPropertiesForDetailedOutput = 3;
 
+  // Constructor address -> site, transitions of a Map share its
+  // constructor and reading the script source is slow.
+  typedef std::unordered_map<int64_t, std::string> SiteCache;
+
   struct MapCacheEntry {
     enum ShowArrayLength { kShowArrayLength, kDontShowArrayLength };
 
     std::string type_name;
     bool is_histogram;
     bool is_context;
+    bool is_free_space;
+    bool is_array_buffer;
+    bool is_code;
+    bool is_js_function;
+    bool is_global;
+    bool is_collection;
+    bool is_promise;
+    bool is_js_array;
+    bool is_string;
+
+    // Constructor and its source location, or the type name.
+    std::string site;
+    // Root of the transition tree, reached through the back pointers.
+    int64_t root_map = 0;
+    int64_t transition_depth = 0;
+    bool is_dictionary = false;
+    // Size of every instance, read once per Map
+    uint64_t instance_size = 0;
+    // Elements of arrays, unknown if it depends on the backing store
+    v8::Map::ElementsStore elements_store = v8::Map::kUnknownElements;
+    // Where instances are counted, owned by LLScan
+    MapRecord* record = nullptr;
+
+    // Bounds the walk of corrupted back pointers.
+    static const int64_t kMaxTransitionDepth = 1 << 16;
 
     std::vector<std::string> properties_;
     uint64_t own_descriptors_count_ = 0;
@@ -311,21 +794,33 @@ class FindJSObjectsVisitor : MemoryVisitor {
 
     std::string GetTypeNameWithProperties(
         ShowArrayLength show_array_length = kShowArrayLength,
-        size_t max_properties = 0);
+        size_t max_properties = 0) const;
 
     bool Load(v8::Map map, v8::HeapObject heap_object, v8::LLV8* llv8,
-              Error& err);
+              SiteCache& sites, Error& err);
   };
 
   static bool IsAHistogramType(v8::Map& map, Error& err);
 
+  // Per object work of Visit(), Layout specialises the fields read from
+  // every object counted.
+  template <class Layout>
+  uint64_t VisitHeapObject(v8::HeapObject heap_object, v8::Map map);
+
   void InsertOnContexts(uint64_t word, Error& err);
-  void InsertOnMapsToInstances(uint64_t word, v8::Map map,
-                               FindJSObjectsVisitor::MapCacheEntry map_info,
-                               Error& err);
-  void InsertOnDetailedMapsToInstances(
-      uint64_t word, v8::Map map, FindJSObjectsVisitor::MapCacheEntry map_info,
-      Error& err);
+  template <class Layout>
+  void InsertOnFreeSpaces(uint64_t word, Error& err);
+  void InsertOnArrayBuffers(uint64_t word, Error& err);
+  void InsertOnGlobalObjects(uint64_t word, Error& err);
+  bool InsertOnMapsToInstances(uint64_t word, const MapCacheEntry& map_info);
+  void InsertOnDetailedMapsToInstances(uint64_t word,
+                                       const MapCacheEntry& map_info);
+  template <class Layout>
+  void InsertOnMaps(v8::HeapObject heap_object, v8::Map map,
+                    MapCacheEntry& map_info, Error& err);
+  template <class Layout>
+  void InsertOnHistograms(v8::HeapObject heap_object,
+                          const MapCacheEntry& map_info, Error& err);
 
   lldb::SBTarget& target_;
   uint32_t address_byte_size_;
@@ -333,22 +828,36 @@ class FindJSObjectsVisitor : MemoryVisitor {
 
   LLScan* const llscan_;
   std::map<int64_t, MapCacheEntry> map_cache_;
+  SiteCache sites_;
+  ScanHistograms histograms_;
+  std::unordered_set<uint64_t> free_spaces_;
 };
 
 
 class LLScan {
  public:
-  LLScan(v8::LLV8* llv8) : llv8_(llv8) {}
+  LLScan(v8::LLV8* llv8) : llv8_(llv8), code_map_(llv8) {}
+  ~LLScan();
 
   v8::LLV8* v8() { return llv8_; }
 
+  // Called as the scan goes with the bytes scanned so far and the total,
+  // returning false cancels the scan.
+  typedef std::function<bool(uint64_t scanned, uint64_t total)> ScanProgress;
+
   bool ScanHeapForObjects(lldb::SBTarget target,
-                          lldb::SBCommandReturnObject& result);
+                          lldb::SBCommandReturnObject& result,
+                          ScanProgress progress = nullptr);
 
   inline TypeRecordMap& GetMapsToInstances() { return mapstoinstances_; };
   inline DetailedTypeRecordMap& GetDetailedMapsToInstances() {
     return detailedmapstoinstances_;
   };
+  // Instances grouped by constructor and its source location.
+  inline TypeRecordMap& GetSitesToInstances() { return sitestoinstances_; };
+  // Maps of the objects counted above.
+  inline MapRecordMap& GetMaps() { return maps_; };
+  inline const ScanHistograms& GetHistograms() { return histograms_; };
 
   // References By Value
   inline bool AreReferencesByValueLoaded() {
@@ -387,22 +896,62 @@ class LLScan {
   inline bool AreContextsLoaded() { return contexts_.size() > 0; };
   inline ContextVector* GetContexts() { return &contexts_; }
 
+  // Contexts holding a value in one of their locals, loaded on first use.
+  ReferencesVector* GetContextsByValue(uint64_t address);
+
+  // ArrayBuffers
+  inline ArrayBufferSet* GetArrayBuffers() { return &array_buffers_; }
+
+  // JSFunctions and global objects, which aren't histogram types
+  inline FunctionSet* GetFunctions() { return &functions_; }
+  inline GlobalObjectSet* GetGlobalObjects() { return &global_objects_; }
+
+  // Map, Set, WeakMap and WeakSet instances
+  inline CollectionSet* GetCollections() { return &collections_; }
+  inline PromiseSet* GetPromises() { return &promises_; }
+
+  // PC -> builtin or Code object
+  inline v8::CodeMap* GetCodeMap() { return &code_map_; }
+
+  // Heap pages
+  inline HeapPageMap& GetHeapPages() { return heap_pages_; };
+  HeapPage* GetHeapPage(uint64_t address);
+  // totals has an entry for each HeapPage::Space.
+  void GetHeapSpaceTotals(HeapSpaceTotals* totals);
+
   v8::LLV8* llv8_;
 
  private:
-  void ScanMemoryRegions(FindJSObjectsVisitor& v);
+  bool ScanMemoryRegions(FindJSObjectsVisitor& v, ScanProgress& progress);
+  template <class Layout>
+  bool ScanMemoryRegions(FindJSObjectsVisitor& v, ScanProgress& progress);
+  // Sums the instances of each site from its Maps, without their addresses.
+  void LoadSitesToInstances();
   void ClearMapsToInstances();
   void ClearReferences();
+  void ClearHeapPages();
 
   lldb::SBTarget target_;
   lldb::SBProcess process_;
   TypeRecordMap mapstoinstances_;
   DetailedTypeRecordMap detailedmapstoinstances_;
+  TypeRecordMap sitestoinstances_;
+  MapRecordMap maps_;
+  ScanHistograms histograms_;
 
   ReferencesByValueMap references_by_value_;
   ReferencesByPropertyMap references_by_property_;
   ReferencesByStringMap references_by_string_;
   ContextVector contexts_;
+  ContextsByValueMap contexts_by_value_;
+  bool contexts_by_value_loaded_ = false;
+  ArrayBufferSet array_buffers_;
+  FunctionSet functions_;
+  GlobalObjectSet global_objects_;
+  CollectionSet collections_;
+  PromiseSet promises_;
+  HeapPageMap heap_pages_;
+  v8::CodeMap code_map_;
 };
 
 }  // namespace llnode
@@ -130,6 +130,13 @@ void Map::Load() {
   }
   kLayoutDescriptor =
       LoadConstant({"class_Map__layout_descriptor__LayoutDescriptor"});
+
+  kBitField2Offset = LoadConstant(
+      {"class_Map__bit_field2__char", "class_Map__bit_field2__uint8_t"});
+  kElementsKindMask = LoadConstant({"bit_field2_elements_kind_mask"});
+  kElementsKindShift = LoadConstant({"bit_field2_elements_kind_shift"});
+  kFastHoleyElementsKind = LoadConstant({"elements_fast_holey_elements"});
+  kDictionaryElementsKind = LoadConstant({"elements_dictionary_elements"});
 }
 
 
@@ -188,6 +195,9 @@ void JSFunction::Load() {
     // TODO(indutny): check V8 version?
     kContextOffset = kSharedInfoOffset + common_->kPointerSize;
   }
+
+  kCodeOffset = LoadConstant(
+      {"class_JSFunction__code__Code", "class_JSFunction__code__Object"});
 }
 
 
@@ -201,6 +211,47 @@ void JSDate::Load() {
 };
 
 
+void JSCollection::Load() {
+  // The table is the first field after the JSObject header (map, properties
+  // and elements).
+  common_->Load();
+  kTableOffset = LoadConstant("class_JSCollection__table__Object",
+                              3 * common_->kPointerSize);
+  kWeakTableOffset =
+      LoadConstant("class_JSWeakCollection__table__Object", kTableOffset);
+};
+
+
+void JSPromise::Load() {
+  common_->Load();
+  int64_t pointer_size = common_->kPointerSize;
+  kReactionsOrResultOffset = LoadConstant(
+      "class_JSPromise__reactions_or_result__Object", 3 * pointer_size);
+  kFlagsOffset = LoadConstant("class_JSPromise__flags__SMI",
+                              kReactionsOrResultOffset + pointer_size);
+
+  kReactionNextOffset =
+      LoadConstant("class_PromiseReaction__next__Object", pointer_size);
+  kReactionRejectHandlerOffset = LoadConstant(
+      "class_PromiseReaction__reject_handler__Object", 2 * pointer_size);
+  kReactionFulfillHandlerOffset = LoadConstant(
+      "class_PromiseReaction__fulfill_handler__Object", 3 * pointer_size);
+  kReactionPromiseOrCapabilityOffset = LoadConstant(
+      "class_PromiseReaction__promise_or_capability__Object",
+      4 * pointer_size);
+  kCapabilityPromiseOffset =
+      LoadConstant("class_PromiseCapability__promise__Object", pointer_size);
+
+  // Right after the JSObject header, the promise after the seven fields of
+  // JSGeneratorObject.
+  kGeneratorFunctionOffset = LoadConstant(
+      "class_JSGeneratorObject__function__JSFunction", 3 * pointer_size);
+  kAsyncFunctionPromiseOffset =
+      LoadConstant("class_JSAsyncFunctionObject__promise__JSPromise",
+                   kGeneratorFunctionOffset + 7 * pointer_size);
+};
+
+
 void SharedInfo::Load() {
   kFunctionDataOffset =
       LoadConstant("class_SharedFunctionInfo__function_data__Object");
@@ -283,6 +334,7 @@ void Context::Load() {
   kScopeInfoIndex = LoadConstant("context_idx_scope_info", -1);
   kPreviousIndex =
       LoadConstant("class_Context__previous_index__int", "context_idx_prev");
+  kExtensionIndex = LoadConstant("context_idx_ext", kPreviousIndex + 1);
   // TODO (mmarchini) change LoadConstant to accept variable arguments, a list
   // of constants or a fallback list).
   kNativeIndex =
@@ -587,6 +639,38 @@ void Symbol::Load() {
 }
 
 
+void MemoryChunk::Load() {
+  // NOTE: V8 doesn't export its page layout to postmortem metadata. Every
+  // release we support starts a chunk with `size_t size_; uintptr_t flags_;`
+  // and keeps the flag bits below stable, only the page size changed.
+  common_->Load();
+  int64_t page_size_bits = 20;
+  if (common_->CheckLowestVersion(6, 0, 0)) {
+    page_size_bits = 18;
+  } else if (common_->CheckLowestVersion(5, 3, 0)) {
+    page_size_bits = 19;
+  }
+  kPageSize = int64_t(1) << page_size_bits;
+
+  kSizeOffset = 0;
+  kFlagsOffset = kSizeOffset + common_->kPointerSize;
+
+  kIsExecutableFlag = 1 << 0;
+  kInFromSpaceFlag = 1 << 3;
+  kInToSpaceFlag = 1 << 4;
+}
+
+
+void FreeSpace::Load() {
+  // size is the first field after the map
+  common_->Load();
+  int64_t size_offset =
+      LoadConstant("class_HeapObject__map__Map") + common_->kPointerSize;
+  kSizeOffset =
+      *LoadOptionalConstant({"class_FreeSpace__size__SMI"}, size_offset);
+}
+
+
 void Types::Load() {
   kFirstNonstringType = LoadConstant("FirstNonstringType");
   kFirstJSObjectType =
@@ -617,11 +701,23 @@ void Types::Load() {
   kCodeType = LoadConstant("type_Code__CODE_TYPE");
   kJSFunctionType = LoadConstant("type_JSFunction__JS_FUNCTION_TYPE");
   kFixedArrayType = LoadConstant("type_FixedArray__FIXED_ARRAY_TYPE");
+  kFixedDoubleArrayType =
+      LoadConstant({"type_FixedDoubleArray__FIXED_DOUBLE_ARRAY_TYPE"});
   kJSArrayBufferType = LoadConstant("type_JSArrayBuffer__JS_ARRAY_BUFFER_TYPE");
   kJSTypedArrayType = LoadConstant("type_JSTypedArray__JS_TYPED_ARRAY_TYPE");
   kJSRegExpType = LoadConstant(
       {"type_JSRegExp__JS_REG_EXP_TYPE", "type_JSRegExp__JS_REGEXP_TYPE"});
   kJSDateType = LoadConstant("type_JSDate__JS_DATE_TYPE");
+  kJSMapType = LoadConstant("type_JSMap__JS_MAP_TYPE");
+  kJSSetType = LoadConstant("type_JSSet__JS_SET_TYPE");
+  kJSWeakMapType = LoadConstant("type_JSWeakMap__JS_WEAK_MAP_TYPE");
+  kJSWeakSetType = LoadConstant("type_JSWeakSet__JS_WEAK_SET_TYPE");
+  kPromiseReactionType =
+      LoadConstant("type_PromiseReaction__PROMISE_REACTION_TYPE");
+  kPromiseCapabilityType =
+      LoadConstant("type_PromiseCapability__PROMISE_CAPABILITY_TYPE");
+  kJSAsyncFunctionObjectType = LoadConstant(
+      "type_JSAsyncFunctionObject__JS_ASYNC_FUNCTION_OBJECT_TYPE");
   kSharedFunctionInfoType =
       LoadConstant("type_SharedFunctionInfo__SHARED_FUNCTION_INFO_TYPE");
   kUncompiledDataWithoutPreParsedScopeType = LoadConstant(
@@ -637,6 +733,7 @@ void Types::Load() {
   kScriptType = LoadConstant("type_Script__SCRIPT_TYPE");
   kScopeInfoType = LoadConstant("type_ScopeInfo__SCOPE_INFO_TYPE");
   kSymbolType = LoadConstant("type_Symbol__SYMBOL_TYPE");
+  kFreeSpaceType = LoadConstant("type_FreeSpace__FREE_SPACE_TYPE");
 
   if (kJSAPIObjectType == -1) {
     common_->Load();
@@ -83,6 +83,13 @@ class Map : public Module {
   int64_t kNumberOfOwnDescriptorsShift;
   int64_t kDictionaryMapShift;
 
+  // Elements kind, tagged (Smi or object) kinds come before the holey one
+  Constant<int64_t> kBitField2Offset;
+  Constant<int64_t> kElementsKindMask;
+  Constant<int64_t> kElementsKindShift;
+  Constant<int64_t> kFastHoleyElementsKind;
+  Constant<int64_t> kDictionaryElementsKind;
+
   bool HasUnboxedDoubleFields();
 
  protected:
@@ -127,6 +134,7 @@ class JSFunction : public Module {
 
   int64_t kSharedInfoOffset;
   int64_t kContextOffset;
+  Constant<int64_t> kCodeOffset;
 
  protected:
   void Load();
@@ -152,6 +160,62 @@ class JSDate : public Module {
   void Load();
 };
 
+class JSCollection : public Module {
+ public:
+  CONSTANTS_DEFAULT_METHODS(JSCollection);
+
+  // Map and Set point to an OrderedHashTable, WeakMap and WeakSet to an
+  // ObjectHashTable (EphemeronHashTable in newer V8s).
+  int64_t kTableOffset;
+  int64_t kWeakTableOffset;
+
+  // Both tables start with these fields, they aren't part of the postmortem
+  // metadata but haven't changed since V8 4.x. The third one is the number
+  // of buckets of an OrderedHashTable and the capacity of an ObjectHashTable.
+  static const int64_t kNumberOfElementsIndex = 0;
+  static const int64_t kNumberOfDeletedElementsIndex = 1;
+  static const int64_t kNumberOfBucketsIndex = 2;
+  static const int64_t kHashTableStartIndex = 3;
+
+  // Words per entry: key, value and chain for a Map, key and chain for a
+  // Set, key and value for both weak tables.
+  static const int64_t kMapEntrySize = 3;
+  static const int64_t kSetEntrySize = 2;
+  static const int64_t kWeakEntrySize = 2;
+
+ protected:
+  void Load();
+};
+
+class JSPromise : public Module {
+ public:
+  CONSTANTS_DEFAULT_METHODS(JSPromise);
+
+  // A pending promise points to its PromiseReaction list (Smi zero when
+  // nothing waits on it), a settled one to its result.
+  int64_t kReactionsOrResultOffset;
+  int64_t kFlagsOffset;
+
+  // PromiseReaction and PromiseCapability are Structs, their fields are only
+  // in the metadata of some V8 versions but haven't moved since V8 6.6.
+  int64_t kReactionNextOffset;
+  int64_t kReactionRejectHandlerOffset;
+  int64_t kReactionFulfillHandlerOffset;
+  int64_t kReactionPromiseOrCapabilityOffset;
+  int64_t kCapabilityPromiseOffset;
+
+  // `await` suspends a JSAsyncFunctionObject (a JSGeneratorObject which also
+  // holds the promise returned by the async function).
+  int64_t kGeneratorFunctionOffset;
+  int64_t kAsyncFunctionPromiseOffset;
+
+  static const int64_t kStatusMask = 3;
+  static const int64_t kHasHandlerMask = 1 << 2;
+
+ protected:
+  void Load();
+};
+
 class SharedInfo : public Module {
  public:
   CONSTANTS_DEFAULT_METHODS(SharedInfo);
@@ -220,6 +284,7 @@ class Context : public Module {
   int64_t kScopeInfoIndex;
   int64_t kGlobalObjectIndex;
   int64_t kPreviousIndex;
+  int64_t kExtensionIndex;
   int64_t kNativeIndex;
   int64_t kEmbedderDataIndex;
   int64_t kMinContextSlots;
@@ -519,6 +584,34 @@ class Symbol : public Module {
 };
 
 
+class MemoryChunk : public Module {
+ public:
+  CONSTANTS_DEFAULT_METHODS(MemoryChunk);
+
+  int64_t kPageSize;
+  int64_t kSizeOffset;
+  int64_t kFlagsOffset;
+
+  int64_t kIsExecutableFlag;
+  int64_t kInFromSpaceFlag;
+  int64_t kInToSpaceFlag;
+
+ protected:
+  void Load();
+};
+
+
+class FreeSpace : public Module {
+ public:
+  CONSTANTS_DEFAULT_METHODS(FreeSpace);
+
+  int64_t kSizeOffset;
+
+ protected:
+  void Load();
+};
+
+
 class Types : public Module {
  public:
   CONSTANTS_DEFAULT_METHODS(Types);
@@ -543,16 +636,25 @@ class Types : public Module {
   int64_t kCodeType;
   int64_t kJSFunctionType;
   int64_t kFixedArrayType;
+  Constant<int64_t> kFixedDoubleArrayType;
   int64_t kJSArrayBufferType;
   int64_t kJSTypedArrayType;
   Constant<int64_t> kJSRegExpType;
   int64_t kJSDateType;
+  int64_t kJSMapType;
+  int64_t kJSSetType;
+  int64_t kJSWeakMapType;
+  int64_t kJSWeakSetType;
+  int64_t kPromiseReactionType;
+  int64_t kPromiseCapabilityType;
+  int64_t kJSAsyncFunctionObjectType;
   int64_t kSharedFunctionInfoType;
   Constant<int64_t> kUncompiledDataWithoutPreParsedScopeType;
   Constant<int64_t> kUncompiledDataWithPreParsedScopeType;
   int64_t kScriptType;
   int64_t kScopeInfoType;
   int64_t kSymbolType;
+  int64_t kFreeSpaceType;
 
  protected:
   void Load();
@@ -50,6 +50,35 @@ inline CheckedType<int32_t> LLV8::LoadValue<CheckedType<int32_t>>(
   return LoadUnsigned<int32_t>(addr, 4);
 }
 
+template <class Layout>
+inline int64_t LLV8::LoadField(int64_t raw, int64_t offset, Error& err) {
+  return LoadPtr(layout::FieldAddress<Layout>(raw, offset), err);
+}
+
+template <>
+inline int64_t LLV8::LoadField<layout::Dynamic>(int64_t raw, int64_t offset,
+                                                Error& err) {
+  return LoadPtr(raw - heap_obj()->kTag + offset, err);
+}
+
+template <class Layout>
+inline bool LLV8::LoadSmiField(int64_t raw, int64_t offset, int64_t* value,
+                               Error& err) {
+  int64_t field = LoadField<Layout>(raw, offset, err);
+  if (err.Fail() || !layout::IsSmi<Layout>(field)) return false;
+  *value = layout::SmiValue<Layout>(field);
+  return true;
+}
+
+template <>
+inline bool LLV8::LoadSmiField<layout::Dynamic>(int64_t raw, int64_t offset,
+                                                int64_t* value, Error& err) {
+  Smi field(this, LoadField<layout::Dynamic>(raw, offset, err));
+  if (err.Fail() || !field.Check()) return false;
+  *value = field.GetValue();
+  return true;
+}
+
 template <class T>
 inline T LLV8::LoadValue(int64_t addr, Error& err) {
   int64_t ptr;
@@ -260,6 +289,30 @@ inline bool Map::IsDictionary(Error& err) {
 }
 
 
+inline Map::ElementsStore Map::GetElementsStore(Error& err) {
+  constants::Map* map = v8()->map();
+  if (!map->kBitField2Offset.Check() || !map->kElementsKindMask.Check() ||
+      !map->kElementsKindShift.Check()) {
+    return kUnknownElements;
+  }
+
+  int64_t field =
+      v8()->LoadUnsigned(LeaField(*map->kBitField2Offset), 1, err);
+  if (err.Fail()) return kUnknownElements;
+
+  int64_t kind = (field & *map->kElementsKindMask) >> *map->kElementsKindShift;
+  if (map->kFastHoleyElementsKind.Check() &&
+      kind <= *map->kFastHoleyElementsKind) {
+    return kTaggedElements;
+  }
+  if (map->kDictionaryElementsKind.Check() &&
+      kind == *map->kDictionaryElementsKind) {
+    return kDictionaryElements;
+  }
+  return kUnknownElements;
+}
+
+
 inline int64_t Map::NumberOfOwnDescriptors(Error& err) {
   int64_t field = BitField3(err);
   if (err.Fail()) return false;
@@ -439,6 +492,70 @@ ACCESSOR(JSRegExp, GetSource, js_regexp()->kSourceOffset, String)
 
 ACCESSOR(JSDate, GetValue, js_date()->kValueOffset, Value)
 
+inline JSCollection::Kind JSCollection::GetKind(LLV8* v8, int64_t type) {
+  // Types missing from the postmortem metadata are -1.
+  if (type < 0) return kNotACollection;
+  if (type == v8->types()->kJSMapType) return kMap;
+  if (type == v8->types()->kJSSetType) return kSet;
+  if (type == v8->types()->kJSWeakMapType) return kWeakMap;
+  if (type == v8->types()->kJSWeakSetType) return kWeakSet;
+  return kNotACollection;
+}
+
+inline bool JSCollection::IsCollectionType(LLV8* v8, int64_t type) {
+  return GetKind(v8, type) != kNotACollection;
+}
+
+inline JSCollection::Kind JSCollection::GetKind(Error& err) {
+  int64_t type = GetType(err);
+  if (err.Fail()) return kNotACollection;
+  return GetKind(v8(), type);
+}
+
+inline FixedArray JSCollection::Table(Error& err) {
+  Kind kind = GetKind(err);
+  if (err.Fail()) return FixedArray();
+  if (kind == kNotACollection) {
+    err = Error::Failure("Not a collection");
+    return FixedArray();
+  }
+
+  int64_t offset = kind == kWeakMap || kind == kWeakSet
+                       ? v8()->js_collection()->kWeakTableOffset
+                       : v8()->js_collection()->kTableOffset;
+  return LoadFieldValue<FixedArray>(offset, err);
+}
+
+inline bool JSPromise::IsPromiseType(LLV8* v8, int64_t type) {
+  return type == v8->types()->kJSPromiseType;
+}
+
+inline int64_t JSPromise::Flags(Error& err) {
+  Smi flags = LoadFieldValue<Smi>(v8()->js_promise()->kFlagsOffset, err);
+  if (err.Fail()) return 0;
+  if (!flags.Check()) {
+    err = Error::Failure("Invalid promise flags");
+    return 0;
+  }
+  return flags.GetValue();
+}
+
+inline JSPromise::Status JSPromise::GetStatus(Error& err) {
+  int64_t status = Flags(err) & constants::JSPromise::kStatusMask;
+  if (err.Fail()) return kPending;
+  if (status > kRejected) {
+    err = Error::Failure("Invalid promise status %" PRId64, status);
+    return kPending;
+  }
+  return static_cast<Status>(status);
+}
+
+inline bool JSPromise::HasHandler(Error& err) {
+  return (Flags(err) & constants::JSPromise::kHasHandlerMask) != 0;
+}
+
+ACCESSOR(JSPromise, Result, js_promise()->kReactionsOrResultOffset, Value)
+
 bool String::IsString(LLV8* v8, HeapObject heap_object, Error& err) {
   if (!heap_object.Check()) return false;
 
@@ -824,6 +941,7 @@ inline int64_t SharedFunctionInfo::EndPosition(Error& err) {
 ACCESSOR(JSFunction, Info, js_function()->kSharedInfoOffset,
          SharedFunctionInfo);
 ACCESSOR(JSFunction, GetContext, js_function()->kContextOffset, HeapObject);
+SAFE_ACCESSOR(JSFunction, GetCode, js_function()->kCodeOffset, HeapObject);
 
 SAFE_ACCESSOR(ConsString, First, cons_string()->kFirstOffset, String);
 SAFE_ACCESSOR(ConsString, Second, cons_string()->kSecondOffset, String);
@@ -1051,6 +1169,10 @@ inline Value Context::Previous(Error& err) {
   return FixedArray::Get<Value>(v8()->context()->kPreviousIndex, err);
 }
 
+inline Value Context::Extension(Error& err) {
+  return FixedArray::Get<Value>(v8()->context()->kExtensionIndex, err);
+}
+
 inline Value Context::Native(Error& err) {
   return FixedArray::Get<Value>(v8()->context()->kNativeIndex, err);
 }
@@ -1180,6 +1302,37 @@ inline bool Oddball::IsHole(Error& err) {
   return kind.GetValue() == v8()->oddball()->kTheHole;
 }
 
+ACCESSOR(FreeSpace, Size, free_space()->kSizeOffset, Smi)
+
+inline MemoryChunk MemoryChunk::FromAddress(LLV8* v8, int64_t addr) {
+  return MemoryChunk(v8, addr & ~(v8->memory_chunk()->kPageSize - 1));
+}
+
+inline int64_t MemoryChunk::Size(Error& err) {
+  return v8()->LoadPtr(raw() + v8()->memory_chunk()->kSizeOffset, err);
+}
+
+inline int64_t MemoryChunk::Flags(Error& err) {
+  return v8()->LoadPtr(raw() + v8()->memory_chunk()->kFlagsOffset, err);
+}
+
+inline bool MemoryChunk::IsExecutable(int64_t flags) {
+  return (flags & v8()->memory_chunk()->kIsExecutableFlag) != 0;
+}
+
+inline bool MemoryChunk::InNewSpace(int64_t flags) {
+  return (flags & (v8()->memory_chunk()->kInFromSpaceFlag |
+                   v8()->memory_chunk()->kInToSpaceFlag)) != 0;
+}
+
+inline bool MemoryChunk::IsRegularPage(int64_t size) {
+  return size == v8()->memory_chunk()->kPageSize;
+}
+
+inline bool MemoryChunk::IsLargePage(int64_t size) {
+  return size > v8()->memory_chunk()->kPageSize;
+}
+
 // TODO(mmarchini): return CheckedType
 inline bool JSArrayBuffer::WasNeutered(Error& err) {
   CheckedType<int64_t> bit_field = BitField();
@@ -0,0 +1,69 @@
+#ifndef SRC_LLV8_LAYOUT_H_
+#define SRC_LLV8_LAYOUT_H_
+
+#include <cstdint>
+
+namespace llnode {
+namespace v8 {
+namespace layout {
+
+// Compile-time descriptions of the tagged value layout used by the V8
+// releases shipped with the Node.js LTS lines. Code which runs for every word
+// or every object of the heap (e.g. the findjsobjects scan) is instantiated
+// over these, so tag checks, Smi decoding and field addresses fold into
+// immediates instead of loading constants::Smi and constants::HeapObject on
+// each call. Field offsets which differ between releases still come from the
+// loaded constants.
+//
+// A descriptor is only used after LLV8::layout() verified it against the
+// constants loaded from the target, everything else takes the dynamic path.
+template <int64_t PointerSize, int64_t SmiShiftSize>
+struct Tagged {
+  static constexpr int64_t kPointerSize = PointerSize;
+
+  static constexpr int64_t kSmiTag = 0;
+  static constexpr int64_t kSmiTagMask = 1;
+  static constexpr int64_t kSmiShiftSize = SmiShiftSize;
+
+  static constexpr int64_t kHeapObjectTag = 1;
+  static constexpr int64_t kHeapObjectTagMask = 3;
+  static constexpr int64_t kMapOffset = 0;
+};
+
+// 64-bit builds without pointer compression (V8 5.1 - 7.x, Node.js 6 - 12).
+typedef Tagged<8, 31> Tagged64;
+// 32-bit builds.
+typedef Tagged<4, 0> Tagged32;
+
+// Anything else: read every value from the loaded constants. LLV8 has
+// specialisations of its layout-dependent accessors for it.
+struct Dynamic {};
+
+enum Kind { kUnknown, kDynamic, kTagged64, kTagged32 };
+
+template <class Layout>
+inline bool IsSmi(int64_t raw) {
+  return (raw & Layout::kSmiTagMask) == Layout::kSmiTag;
+}
+
+// Same shift as Smi::GetValue(), the tag is one bit wide.
+template <class Layout>
+inline int64_t SmiValue(int64_t raw) {
+  return raw >> (Layout::kSmiShiftSize + Layout::kSmiTagMask);
+}
+
+template <class Layout>
+inline bool IsHeapObject(int64_t raw) {
+  return (raw & Layout::kHeapObjectTagMask) == Layout::kHeapObjectTag;
+}
+
+template <class Layout>
+inline int64_t FieldAddress(int64_t raw, int64_t offset) {
+  return raw - Layout::kHeapObjectTag + offset;
+}
+
+}  // namespace layout
+}  // namespace v8
+}  // namespace llnode
+
+#endif  // SRC_LLV8_LAYOUT_H_
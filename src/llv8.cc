@@ -4,6 +4,7 @@
 #include <cinttypes>
 #include <cstdarg>
 #include <iomanip>
+#include <memory>
 #include <sstream>
 #include <string>
 
@@ -25,10 +26,14 @@ void LLV8::Load(SBTarget target) {
   // Reload process anyway
   process_ = target.GetProcess();
 
+  // Keep the constants looked up by the previous command for later sessions.
+  if (target_.IsValid()) SymbolIndex::Update(target_);
+
   // No need to reload
   if (target_ == target) return;
 
   target_ = target;
+  layout_ = layout::kUnknown;
 
   common.Assign(target);
   smi.Assign(target, &common);
@@ -59,13 +64,44 @@ void LLV8::Load(SBTarget target) {
   js_array_buffer_view.Assign(target, &common);
   js_regexp.Assign(target, &common);
   js_date.Assign(target, &common);
+  js_collection.Assign(target, &common);
+  js_promise.Assign(target, &common);
   descriptor_array.Assign(target, &common);
   name_dictionary.Assign(target, &common);
   frame.Assign(target, &common);
   symbol.Assign(target, &common);
+  memory_chunk.Assign(target, &common);
+  free_space.Assign(target, &common);
   types.Assign(target, &common);
 }
 
+template <class Layout>
+bool LLV8::MatchesLayout() {
+  return common()->kPointerSize == Layout::kPointerSize &&
+         smi()->kTag == Layout::kSmiTag &&
+         smi()->kTagMask == Layout::kSmiTagMask &&
+         smi()->kShiftSize == Layout::kSmiShiftSize &&
+         heap_obj()->kTag == Layout::kHeapObjectTag &&
+         heap_obj()->kTagMask == Layout::kHeapObjectTagMask &&
+         heap_obj()->kMapOffset == Layout::kMapOffset;
+}
+
+layout::Kind LLV8::layout() {
+  if (layout_ != layout::kUnknown) return layout_;
+
+  layout_ = layout::kDynamic;
+  // Older releases aren't described, and a descriptor is only trusted if the
+  // target agrees with every value in it.
+  if (!common()->CheckLowestVersion(5, 1, 0)) return layout_;
+
+  if (MatchesLayout<layout::Tagged64>()) {
+    layout_ = layout::kTagged64;
+  } else if (MatchesLayout<layout::Tagged32>()) {
+    layout_ = layout::kTagged32;
+  }
+  return layout_;
+}
+
 int64_t LLV8::LoadPtr(int64_t addr, Error& err) {
   SBError sberr;
   int64_t value =
@@ -684,6 +720,11 @@ std::string HeapObject::GetTypeName(Error& err) {
     return "(Date)";
   }
 
+  JSCollection::Kind kind = JSCollection::GetKind(v8(), type);
+  if (kind != JSCollection::kNotACollection) {
+    return std::string("(JS") + JSCollection::KindName(kind) + ")";
+  }
+
   std::string unknown("unknown: ");
 
   return unknown + std::to_string(type);
@@ -727,6 +768,229 @@ std::string JSDate::ToString(Error& err) {
   return "";
 }
 
+const char* JSCollection::KindName(Kind kind) {
+  switch (kind) {
+    case kMap:
+      return "Map";
+    case kSet:
+      return "Set";
+    case kWeakMap:
+      return "WeakMap";
+    case kWeakSet:
+      return "WeakSet";
+    default:
+      return "";
+  }
+}
+
+
+int64_t JSCollection::Size(Error& err) {
+  FixedArray table = Table(err);
+  if (err.Fail()) return -1;
+
+  Smi size =
+      table.Get<Smi>(constants::JSCollection::kNumberOfElementsIndex, err);
+  if (err.Fail()) return -1;
+  return size.GetValue();
+}
+
+
+int64_t JSCollection::TableSize(Error& err) {
+  FixedArray table = Table(err);
+  if (err.Fail()) return -1;
+
+  Smi length = table.Length(err);
+  if (err.Fail()) return -1;
+  return v8()->fixed_array()->kDataOffset +
+         length.GetValue() * v8()->common()->kPointerSize;
+}
+
+
+std::vector<std::pair<Value, Value>> JSCollection::CollectionEntries(
+    Error& err) {
+  typedef constants::JSCollection Layout;
+  std::vector<std::pair<Value, Value>> entries;
+
+  Kind kind = GetKind(err);
+  FixedArray table = Table(err);
+  if (err.Fail()) return entries;
+
+  Smi length_smi = table.Length(err);
+  if (err.Fail()) return entries;
+  int64_t length = length_smi.GetValue();
+  if (length < Layout::kHashTableStartIndex) {
+    err = Error::Failure("Invalid collection table, length=%" PRId64, length);
+    return entries;
+  }
+
+  // One read for the whole table instead of one per slot.
+  int64_t pointer_size = v8()->common()->kPointerSize;
+  std::unique_ptr<uint8_t[]> data(
+      v8()->LoadChunk(table.LeaData(), length * pointer_size, err));
+  if (err.Fail()) return entries;
+  auto word = [&](int64_t index) {
+    int64_t raw = 0;
+    memcpy(&raw, data.get() + index * pointer_size, pointer_size);
+    return raw;
+  };
+
+  int64_t elements = Smi(v8(), word(Layout::kNumberOfElementsIndex)).GetValue();
+  int64_t deleted =
+      Smi(v8(), word(Layout::kNumberOfDeletedElementsIndex)).GetValue();
+  int64_t buckets = Smi(v8(), word(Layout::kNumberOfBucketsIndex)).GetValue();
+
+  // Ordered tables keep their entries in insertion order after the buckets,
+  // weak tables are open addressed with capacity (buckets) entries.
+  bool weak = kind == kWeakMap || kind == kWeakSet;
+  bool has_values = kind == kMap || kind == kWeakMap;
+  int64_t first = Layout::kHashTableStartIndex;
+  int64_t count = buckets;
+  int64_t entry_size = Layout::kWeakEntrySize;
+  if (!weak) {
+    first += buckets;
+    count = elements + deleted;
+    entry_size = kind == kMap ? Layout::kMapEntrySize : Layout::kSetEntrySize;
+  }
+  if (elements < 0 || deleted < 0 || buckets < 0 ||
+      first + count * entry_size > length) {
+    err = Error::Failure("Invalid collection table at 0x%016" PRIx64,
+                         table.raw());
+    return entries;
+  }
+
+  // Deleted keys are the hole, empty slots of weak tables are undefined.
+  // There is only one of each, so remember them instead of loading the type
+  // of every key.
+  std::vector<int64_t> empty_keys;
+  entries.reserve(elements);
+  for (int64_t i = 0; i < count; i++) {
+    int64_t index = first + i * entry_size;
+    Value key(v8(), word(index));
+
+    if (weak || deleted > 0) {
+      if (std::find(empty_keys.begin(), empty_keys.end(), key.raw()) !=
+          empty_keys.end())
+        continue;
+      Error key_err;
+      bool empty = weak ? key.IsHoleOrUndefined(key_err) : key.IsHole(key_err);
+      if (key_err.Success() && empty) {
+        empty_keys.push_back(key.raw());
+        continue;
+      }
+    }
+
+    Value value = has_values ? Value(v8(), word(index + 1)) : Value();
+    entries.emplace_back(key, value);
+  }
+
+  err = Error::Ok();
+  return entries;
+}
+
+
+const char* JSPromise::StatusName(Status status) {
+  switch (status) {
+    case kPending:
+      return "pending";
+    case kFulfilled:
+      return "fulfilled";
+    case kRejected:
+      return "rejected";
+    default:
+      return "";
+  }
+}
+
+
+std::vector<JSPromise::Reaction> JSPromise::Reactions(Error& err) {
+  std::vector<Reaction> reactions;
+
+  Status status = GetStatus(err);
+  if (err.Fail() || status != kPending) return reactions;
+
+  constants::JSPromise* layout = v8()->js_promise();
+  int64_t reaction_type = v8()->types()->kPromiseReactionType;
+  int64_t capability_type = v8()->types()->kPromiseCapabilityType;
+  int64_t async_function_type = v8()->types()->kJSAsyncFunctionObjectType;
+
+  // The list ends with Smi zero. It is a stack, so the last reaction added
+  // comes first.
+  HeapObject reaction = LoadFieldValue<HeapObject>(
+      layout->kReactionsOrResultOffset, err);
+  while (err.Success() && reaction.Check()) {
+    int64_t type = reaction.GetType(err);
+    if (err.Fail()) break;
+    if (reaction_type != -1 && type != reaction_type) {
+      err = Error::Failure("Invalid promise reaction at 0x%016" PRIx64,
+                           reaction.raw());
+      break;
+    }
+    // A cycle, or not a reaction list after all.
+    if (reactions.size() > kMaxReactions) {
+      err = Error::Failure("Too many reactions on promise 0x%016" PRIx64,
+                           raw());
+      break;
+    }
+
+    Reaction r;
+    r.handler = reaction.LoadFieldValue<Value>(
+        layout->kReactionFulfillHandlerOffset, err);
+    if (err.Fail()) break;
+    // Non-callable handlers are stored as undefined, e.g. the fulfill
+    // handler of catch().
+    Error handler_err;
+    if (r.handler.IsHoleOrUndefined(handler_err)) {
+      r.handler = reaction.LoadFieldValue<Value>(
+          layout->kReactionRejectHandlerOffset, err);
+      if (err.Fail()) break;
+    }
+
+    HeapObject next = reaction.LoadFieldValue<HeapObject>(
+        layout->kReactionPromiseOrCapabilityOffset, err);
+    if (err.Fail()) break;
+    Error next_err;
+    if (next.Check() && capability_type != -1 &&
+        next.GetType(next_err) == capability_type) {
+      next = next.LoadFieldValue<HeapObject>(layout->kCapabilityPromiseOffset,
+                                             next_err);
+    }
+    if (next.Check() && IsPromiseType(v8(), next.GetType(next_err)) &&
+        next_err.Success())
+      r.next = next;
+
+    // `await` handlers are closures whose context extension is the
+    // suspended async function.
+    Error await_err;
+    HeapObject handler(r.handler);
+    if (async_function_type != -1 && handler.Check() &&
+        handler.GetType(await_err) == v8()->types()->kJSFunctionType) {
+      JSFunction fn(handler);
+      HeapObject context_obj = fn.GetContext(await_err);
+      Context context(context_obj);
+      Value extension = context.Extension(await_err);
+      HeapObject generator(extension);
+      if (await_err.Success() && generator.Check() &&
+          generator.GetType(await_err) == async_function_type) {
+        r.async_function = generator.LoadFieldValue<JSFunction>(
+            layout->kGeneratorFunctionOffset, await_err);
+        HeapObject promise = generator.LoadFieldValue<HeapObject>(
+            layout->kAsyncFunctionPromiseOffset, await_err);
+        if (await_err.Success() && promise.Check() &&
+            IsPromiseType(v8(), promise.GetType(await_err)))
+          r.next = promise;
+      }
+    }
+
+    reactions.push_back(r);
+    reaction = reaction.LoadFieldValue<HeapObject>(layout->kReactionNextOffset,
+                                                   err);
+  }
+
+  if (err.Fail()) reactions.clear();
+  std::reverse(reactions.begin(), reactions.end());
+  return reactions;
+}
+
 
 std::string Symbol::ToString(Error& err) {
   if (!String::IsString(v8(), Name(err), err)) {
@@ -884,6 +1148,70 @@ std::vector<std::pair<Value, Value>> JSObject::Entries(Error& err) {
 }
 
 
+Map::ElementsStore JSObject::GetElementsStore(Error& err) {
+  HeapObject map_obj = GetMap(err);
+  if (err.Fail()) return Map::kUnknownElements;
+
+  Map map(map_obj);
+  Map::ElementsStore store = map.GetElementsStore(err);
+  if (err.Fail() || store != Map::kUnknownElements) return store;
+
+  HeapObject elements = Elements(err);
+  if (err.Fail()) return Map::kUnknownElements;
+  int64_t type = elements.GetType(err);
+  if (err.Fail()) return Map::kUnknownElements;
+
+  if (v8()->types()->kFixedDoubleArrayType.Check() &&
+      type == *v8()->types()->kFixedDoubleArrayType) {
+    return Map::kDoubleElements;
+  }
+  // Frozen and sealed elements are still a FixedArray
+  if (type == v8()->types()->kFixedArrayType) return Map::kTaggedElements;
+  return Map::kUnknownElements;
+}
+
+
+std::vector<std::pair<Value, double>> JSObject::DoubleFields(Error& err) {
+  HeapObject map_obj = GetMap(err);
+  if (err.Fail()) return {};
+
+  Map map(map_obj);
+  bool is_dict = map.IsDictionary(err);
+  if (err.Fail() || is_dict) return {};
+
+  HeapObject descriptors_obj = map.InstanceDescriptors(err);
+  RETURN_IF_INVALID(descriptors_obj, {});
+  DescriptorArray descriptors(descriptors_obj);
+
+  int64_t own_descriptors_count = map.NumberOfOwnDescriptors(err);
+  if (err.Fail()) return {};
+  int64_t in_object_count = map.InObjectProperties(err);
+  if (err.Fail()) return {};
+
+  std::vector<std::pair<Value, double>> fields;
+  for (int64_t i = 0; i < own_descriptors_count; i++) {
+    Smi details = descriptors.GetDetails(i);
+    if (!details.Check() || !descriptors.IsFieldDetails(details) ||
+        !descriptors.IsDoubleField(details)) {
+      continue;
+    }
+
+    Value key = descriptors.GetKey(i);
+    if (!key.Check()) continue;
+
+    int64_t index = descriptors.FieldIndex(details) - in_object_count;
+    HeapNumber value = GetDoubleField(index, err);
+    if (err.Fail()) return fields;
+    CheckedType<double> number = value.GetValue(err);
+    if (err.Fail()) return fields;
+    if (!number.Check()) continue;
+
+    fields.push_back(std::pair<Value, double>(key, *number));
+  }
+  return fields;
+}
+
+
 std::vector<std::pair<Value, Value>> JSObject::DictionaryEntries(Error& err) {
   HeapObject dictionary_obj = Properties(err);
   if (err.Fail()) return {};
@@ -1247,6 +1575,43 @@ v8::Value JSObject::GetArrayElement(int64_t pos, Error& err) {
 }
 
 
+std::vector<int64_t> JSObject::InternalFields(Error& err) {
+  std::vector<int64_t> fields;
+
+  HeapObject map_obj = GetMap(err);
+  if (err.Fail()) return fields;
+
+  Map map(map_obj);
+  int64_t type = map.GetType(err);
+  if (err.Fail()) return fields;
+
+  // Only v8::JSObject for now
+  if (!IsObjectType(v8(), type)) return fields;
+
+  int64_t instance_size = map.InstanceSize(err);
+
+  // kVariableSizeSentinel == 0
+  // TODO(indutny): post-mortem constant for this?
+  if (err.Fail() || instance_size == 0) return fields;
+
+  int64_t in_object_props = map.InObjectProperties(err);
+  if (err.Fail()) return fields;
+
+  // in-object properties are appended to the end of the v8::JSObject,
+  // skip them.
+  instance_size -= in_object_props * v8()->common()->kPointerSize;
+
+  for (int64_t off = v8()->js_object()->kInternalFieldsOffset;
+       off < instance_size; off += v8()->common()->kPointerSize) {
+    int64_t field = LoadField(off, err);
+    if (err.Fail()) return std::vector<int64_t>();
+    fields.push_back(field);
+  }
+
+  return fields;
+}
+
+
 bool JSError::HasStackTrace(Error& err) {
   StackTrace stack_trace = GetStackTrace(err);
 
@@ -1360,5 +1725,104 @@ int StackFrame::frame_array_index() {
 }
 
 
+void CodeMap::Load(SBTarget target) {
+  if (target_ == target) return;
+
+  target_ = target;
+  ranges_.clear();
+  owners_.clear();
+
+  static const char kBuiltinsPrefix[] = "Builtins_";
+  static const size_t kBuiltinsPrefixLength = sizeof(kBuiltinsPrefix) - 1;
+
+  for (uint32_t i = 0; i < target.GetNumModules(); i++) {
+    lldb::SBModule module = target.GetModuleAtIndex(i);
+    size_t num_symbols = module.GetNumSymbols();
+
+    for (size_t j = 0; j < num_symbols; j++) {
+      lldb::SBSymbol symbol = module.GetSymbolAtIndex(j);
+      const char* name = symbol.GetName();
+      if (name == nullptr ||
+          strncmp(name, kBuiltinsPrefix, kBuiltinsPrefixLength) != 0) {
+        continue;
+      }
+
+      addr_t start = symbol.GetStartAddress().GetLoadAddress(target);
+      addr_t end = symbol.GetEndAddress().GetLoadAddress(target);
+      if (start == LLDB_INVALID_ADDRESS || end == LLDB_INVALID_ADDRESS ||
+          end <= start) {
+        continue;
+      }
+
+      Range range = {start, end, 0,
+                     "<builtin: " +
+                         std::string(name + kBuiltinsPrefixLength) + ">"};
+      ranges_.push_back(range);
+    }
+  }
+  sorted_ = false;
+}
+
+
+void CodeMap::AddCode(Code code, Error& err) {
+  int64_t size = code.Size(err);
+  if (err.Fail() || size <= 0) return;
+
+  uint64_t start = static_cast<uint64_t>(code.Start());
+  Range range = {start, start + size, code.raw(), std::string()};
+  ranges_.push_back(range);
+  sorted_ = false;
+}
+
+
+void CodeMap::ClearCode() {
+  ranges_.erase(
+      std::remove_if(ranges_.begin(), ranges_.end(),
+                     [](const Range& range) { return range.code != 0; }),
+      ranges_.end());
+  owners_.clear();
+}
+
+
+void CodeMap::AddFunction(JSFunction fn, Error& err) {
+  HeapObject code = fn.GetCode(err);
+  if (err.Fail() || !code.Check()) return;
+
+  SharedFunctionInfo info = fn.Info(err);
+  if (err.Fail()) return;
+
+  // Closures share their code, any of them names it.
+  owners_.emplace(code.raw(), info.raw());
+}
+
+
+std::string CodeMap::Lookup(uint64_t pc, int64_t* code) {
+  if (!sorted_) {
+    std::sort(ranges_.begin(), ranges_.end());
+    sorted_ = true;
+  }
+
+  Range needle = {pc, pc, 0, std::string()};
+  auto it = std::upper_bound(ranges_.begin(), ranges_.end(), needle);
+  if (it == ranges_.begin()) return std::string();
+  --it;
+  if (pc >= it->end) return std::string();
+
+  if (code != nullptr) *code = it->code;
+  if (it->code == 0) return it->name;
+
+  auto owner = owners_.find(it->code);
+  if (owner == owners_.end()) return "<code>";
+
+  Error err;
+  SharedFunctionInfo info(v8_, owner->second);
+  std::string name = info.ProperName(err);
+  if (err.Fail()) return "<code>";
+
+  std::string postfix = info.GetPostfix(err);
+  if (err.Fail()) return "<code: " + name + ">";
+  return "<code: " + name + " at " + postfix + ">";
+}
+
 }  // namespace v8
 }  // namespace llnode
@@ -3,11 +3,14 @@
 
 #include <cstring>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <lldb/API/LLDB.h>
 
 #include "src/error.h"
 #include "src/llv8-constants.h"
+#include "src/llv8-layout.h"
 
 namespace llnode {
 
@@ -21,6 +24,12 @@ class Printer;
 class FindJSObjectsVisitor;
 class FindReferencesCmd;
 class FindObjectsCmd;
+class DuplicateStringsCmd;
+class TimersCmd;
+class RetainersCmd;
+class ContextsCmd;
+class PromisesCmd;
+class LLNodeApi;
 
 namespace v8 {
 
@@ -138,6 +147,15 @@ class Map : public HeapObject {
  public:
   V8_VALUE_DEFAULT_METHODS(Map, HeapObject)
 
+  // How the elements of instances are stored. Fast elements are a FixedArray
+  // of tagged values or a FixedDoubleArray, sparse ones a NumberDictionary.
+  enum ElementsStore {
+    kUnknownElements,
+    kTaggedElements,
+    kDoubleElements,
+    kDictionaryElements
+  };
+
   inline int64_t GetType(Error& err);
   inline HeapObject MaybeConstructor(Error& err);
   inline HeapObject InstanceDescriptors(Error& err);
@@ -149,6 +167,9 @@ class Map : public HeapObject {
 
   inline bool IsDictionary(Error& err);
   inline bool IsJSObjectMap(Error& err);
+  // Tagged or dictionary from the elements kind, unknown for the other kinds
+  // (doubles, frozen...) which depend on the backing store.
+  inline ElementsStore GetElementsStore(Error& err);
   inline int64_t NumberOfOwnDescriptors(Error& err);
 
   HeapObject Constructor(Error& err);
@@ -329,10 +350,20 @@ class JSObject : public HeapObject {
   int64_t GetArrayLength(Error& err);
   Value GetArrayElement(int64_t pos, Error& err);
 
+  // Raw values of the embedder fields, between the header and the in-object
+  // properties.
+  std::vector<int64_t> InternalFields(Error& err);
+
   static inline bool IsObjectType(LLV8* v8, int64_t type);
 
   inline HeapNumber GetDoubleField(int64_t index, Error err);
 
+  // Map::GetElementsStore(), completed with the type of the backing store.
+  Map::ElementsStore GetElementsStore(Error& err);
+
+  // The double fields left out by Entries(), boxed or not.
+  std::vector<std::pair<Value, double>> DoubleFields(Error& err);
+
  protected:
   friend class llnode::Printer;
   template <class T>
@@ -434,6 +465,7 @@ class JSFunction : public JSObject {
 
   inline SharedFunctionInfo Info(Error& err);
   inline HeapObject GetContext(Error& err);
+  inline HeapObject GetCode(Error& err);
   inline std::string Name(Error& err);
 
   std::string GetDebugLine(std::string args, Error& err);
@@ -472,6 +504,68 @@ class FixedArray : public FixedArrayBase {
   inline int64_t LeaData() const;
 };
 
+// Map, Set, WeakMap and WeakSet.
+class JSCollection : public JSObject {
+ public:
+  V8_VALUE_DEFAULT_METHODS(JSCollection, JSObject);
+
+  enum Kind { kMap, kSet, kWeakMap, kWeakSet, kNotACollection };
+
+  static inline Kind GetKind(LLV8* v8, int64_t type);
+  static inline bool IsCollectionType(LLV8* v8, int64_t type);
+  static const char* KindName(Kind kind);
+
+  inline Kind GetKind(Error& err);
+  inline FixedArray Table(Error& err);
+
+  // Number of live entries.
+  int64_t Size(Error& err);
+  // Bytes of the backing hash table.
+  int64_t TableSize(Error& err);
+
+  // Live entries, read from the backing hash table at once. Sets have no
+  // values, the second element of their entries is not Check()ed.
+  std::vector<std::pair<Value, Value>> CollectionEntries(Error& err);
+};
+
+class JSPromise : public JSObject {
+ public:
+  V8_VALUE_DEFAULT_METHODS(JSPromise, JSObject);
+
+  // Same values as v8::Promise::PromiseState.
+  enum Status { kPending, kFulfilled, kRejected };
+
+  struct Reaction {
+    // Run when the promise settles: the fulfill handler, or the reject
+    // handler for catch().
+    Value handler;
+    // For `await`, the async function suspended on the promise.
+    JSFunction async_function;
+    // The promise settled by the reaction: the one returned by then(), or
+    // the one returned by the suspended async function. Not Check()ed if
+    // there is none.
+    HeapObject next;
+  };
+
+  static inline bool IsPromiseType(LLV8* v8, int64_t type);
+  static const char* StatusName(Status status);
+
+  inline Status GetStatus(Error& err);
+  // Whether a handler was attached, rejections without one are unhandled.
+  inline bool HasHandler(Error& err);
+  // Value of a settled promise.
+  inline Value Result(Error& err);
+
+  // Reactions of a pending promise, in the order they were added.
+  std::vector<Reaction> Reactions(Error& err);
+
+ private:
+  // Bounds the walk of a corrupted list.
+  static const size_t kMaxReactions = 1 << 20;
+
+  inline int64_t Flags(Error& err);
+};
+
 class FixedTypedArrayBase : public FixedArrayBase {
  public:
   V8_VALUE_DEFAULT_METHODS(FixedTypedArrayBase, FixedArrayBase)
@@ -535,6 +629,7 @@ class Context : public FixedArray {
 
   inline HeapObject GetScopeInfo(Error& err);
   inline Value Previous(Error& err);
+  inline Value Extension(Error& err);
   inline Value Native(Error& err);
   inline bool IsNative(Error& err);
   template <class T>
@@ -590,6 +685,30 @@ class Oddball : public HeapObject {
   inline bool IsHole(Error& err);
 };
 
+class FreeSpace : public HeapObject {
+ public:
+  V8_VALUE_DEFAULT_METHODS(FreeSpace, HeapObject)
+
+  inline Smi Size(Error& err);
+};
+
+// Header of a V8 heap page. Unlike other values, raw() is the untagged start
+// address of the page.
+class MemoryChunk : public Value {
+ public:
+  V8_VALUE_DEFAULT_METHODS(MemoryChunk, Value)
+
+  static inline MemoryChunk FromAddress(LLV8* v8, int64_t addr);
+
+  inline int64_t Size(Error& err);
+  inline int64_t Flags(Error& err);
+
+  inline bool IsExecutable(int64_t flags);
+  inline bool InNewSpace(int64_t flags);
+  inline bool IsRegularPage(int64_t size);
+  inline bool IsLargePage(int64_t size);
+};
+
 class JSArrayBuffer : public JSObject {
  public:
   V8_VALUE_DEFAULT_METHODS(JSArrayBuffer, JSObject)
@@ -650,13 +769,61 @@ class JSFrame : public Value {
   friend class llnode::Printer;
 };
 
+// Interval index from PCs to the code containing them. It covers the builtins
+// of the embedded blob (Builtins_* symbols) and the Code objects added by the
+// heap scan.
+class CodeMap {
+ public:
+  CodeMap(LLV8* v8) : v8_(v8), sorted_(true) {}
+
+  // Index the builtins of the target, drops everything when it changes.
+  void Load(lldb::SBTarget target);
+
+  void AddCode(Code code, Error& err);
+  // Drop what the heap scan added, keeping the builtins.
+  void ClearCode();
+  // Remember fn as the owner of its code, to name it in Lookup().
+  void AddFunction(JSFunction fn, Error& err);
+
+  // Description of the code containing pc, empty if pc isn't indexed. code
+  // is set to the Code object, or 0 for builtins from the embedded blob.
+  std::string Lookup(uint64_t pc, int64_t* code = nullptr);
+
+ private:
+  struct Range {
+    uint64_t start;
+    uint64_t end;
+    // Code object, 0 for builtins symbols.
+    int64_t code;
+    std::string name;
+
+    bool operator<(const Range& other) const { return start < other.start; }
+  };
+
+  LLV8* v8_;
+  lldb::SBTarget target_;
+  std::vector<Range> ranges_;
+  // Code object -> SharedFunctionInfo of a function running it.
+  std::unordered_map<int64_t, int64_t> owners_;
+  bool sorted_;
+};
+
 class LLV8 {
  public:
   LLV8() : target_(lldb::SBTarget()) {}
 
   void Load(lldb::SBTarget target);
+  // Forget the loaded constants, the next Load() reads them again.
+  void Unload() { target_ = lldb::SBTarget(); }
+
+  // Tagged value layout of the loaded target, one of the compile-time
+  // descriptors from llv8-layout.h when the loaded constants match it.
+  layout::Kind layout();
 
  private:
+  template <class Layout>
+  bool MatchesLayout();
+
   template <class T>
   inline T LoadValue(int64_t addr, Error& err);
 
@@ -665,6 +832,13 @@ class LLV8 {
 
   int64_t LoadConstant(const char* name);
   int64_t LoadPtr(int64_t addr, Error& err);
+  // Fields of the tagged object `raw`, with the tag checks and Smi decoding
+  // of one of the layouts from llv8-layout.h.
+  template <class Layout>
+  inline int64_t LoadField(int64_t raw, int64_t offset, Error& err);
+  template <class Layout>
+  inline bool LoadSmiField(int64_t raw, int64_t offset, int64_t* value,
+                           Error& err);
   template <class T>
   inline CheckedType<T> LoadUnsigned(int64_t addr, uint32_t byte_size);
   int64_t LoadUnsigned(int64_t addr, uint32_t byte_size, Error& err);
@@ -676,6 +850,7 @@ class LLV8 {
 
   lldb::SBTarget target_;
   lldb::SBProcess process_;
+  layout::Kind layout_ = layout::kUnknown;
 
   constants::Common common;
   constants::Smi smi;
@@ -706,10 +881,14 @@ class LLV8 {
   constants::JSArrayBufferView js_array_buffer_view;
   constants::JSRegExp js_regexp;
   constants::JSDate js_date;
+  constants::JSCollection js_collection;
+  constants::JSPromise js_promise;
   constants::DescriptorArray descriptor_array;
   constants::NameDictionary name_dictionary;
   constants::Frame frame;
   constants::Symbol symbol;
+  constants::MemoryChunk memory_chunk;
+  constants::FreeSpace free_space;
   constants::Types types;
 
   friend class Value;
@@ -745,12 +924,22 @@ class LLV8 {
   friend class JSArrayBufferView;
   friend class JSRegExp;
   friend class JSDate;
+  friend class JSCollection;
+  friend class JSPromise;
   friend class CodeMap;
   friend class Symbol;
+  friend class FreeSpace;
+  friend class MemoryChunk;
   friend class llnode::Printer;
   friend class llnode::FindJSObjectsVisitor;
   friend class llnode::FindObjectsCmd;
   friend class llnode::FindReferencesCmd;
+  friend class llnode::DuplicateStringsCmd;
+  friend class llnode::TimersCmd;
+  friend class llnode::RetainersCmd;
+  friend class llnode::ContextsCmd;
+  friend class llnode::PromisesCmd;
+  friend class llnode::LLNodeApi;
   friend class llnode::node::constants::Environment;
 };
 
@@ -1,12 +1,19 @@
 #include <lldb/API/LLDB.h>
+#include <string.h>
+#include <algorithm>
 #include <set>
 
 #include "src/llv8-inl.h"
 #include "src/node-constants.h"
 
+using lldb::SBAddress;
+using lldb::SBError;
 using lldb::SBFrame;
 using lldb::SBProcess;
 using lldb::SBStream;
+using lldb::SBSymbol;
+using lldb::SBSymbolContextList;
+using lldb::SBTarget;
 using lldb::SBThread;
 
 namespace llnode {
@@ -71,7 +78,7 @@ addr_t Environment::LoadCurrentEnvironment(Error& err) {
         v8::Context context(val);
         if (context.IsNative(err)) {
           found = true;
-          current_environment = CurrentEnvironmentFromContext(context, err);
+          current_environment = FromContext(context, err);
           break;
         }
 
@@ -94,8 +101,12 @@ addr_t Environment::LoadCurrentEnvironment(Error& err) {
   return current_environment;
 }
 
-addr_t Environment::CurrentEnvironmentFromContext(v8::Context context,
-                                                  Error& err) {
+addr_t Environment::FromContext(v8::Context context, Error& err) {
+  if (kEnvContextEmbedderDataIndex == -1) {
+    err = Error::Failure("Missing Node's embedder data index");
+    return 0;
+  }
+
   llv8()->Load(target_);
 
   v8::Smi environment =
@@ -133,6 +144,92 @@ void BaseObject::Load() {
   kPersistentHandleOffset = LoadConstant(
       "offset_BaseObject__persistent_handle___v8_Persistent_v8_Object");
 }
+
+void UvLoop::Load() {
+  kPointerSize = target_.GetProcess().GetAddressByteSize();
+
+  // void* data; unsigned int active_handles; void* handle_queue[2];
+  kActiveHandlesOffset = kPointerSize;
+  kHandleQueueOffset = 2 * kPointerSize;
+}
+
+// libuv has no postmortem metadata. Read UV_VERSION_HEX back from
+// `unsigned int uv_version(void)`, which compiles to `mov eax, imm32; ret`
+// (after an endbr64 with CET) on x86. Returns -1 anywhere else.
+static int64_t LoadLibuvVersion(SBTarget target) {
+  SBSymbolContextList contexts = target.FindSymbols("uv_version");
+  if (!contexts.IsValid() || contexts.GetSize() == 0) return -1;
+  SBSymbol symbol = contexts.GetContextAtIndex(0).GetSymbol();
+  if (!symbol.IsValid()) return -1;
+
+  uint8_t code[10];
+  SBAddress start = symbol.GetStartAddress();
+  SBError sberr;
+  target.ReadMemory(start, code, sizeof(code), sberr);
+  if (sberr.Fail()) return -1;
+
+  static const uint8_t kEndbr64[] = {0xf3, 0x0f, 0x1e, 0xfa};
+  size_t mov = memcmp(code, kEndbr64, sizeof(kEndbr64)) == 0 ? 4 : 0;
+  if (code[mov] != 0xb8 || code[mov + 5] != 0xc3) return -1;
+
+  return static_cast<int64_t>(code[mov + 1]) |
+         static_cast<int64_t>(code[mov + 2]) << 8 |
+         static_cast<int64_t>(code[mov + 3]) << 16 |
+         static_cast<int64_t>(code[mov + 4]) << 24;
+}
+
+void UvHandle::Load() {
+  int64_t ptr = target_.GetProcess().GetAddressByteSize();
+
+  // void* data; uv_loop_t* loop; uv_handle_type type; uv_close_cb close_cb;
+  // void* handle_queue[2]; union { int fd; void* reserved[4]; } u;
+  // uv_handle_t* next_closing; unsigned int flags;
+  kLoopOffset = ptr;
+  kTypeOffset = 2 * ptr;
+  kHandleQueueOffset = 4 * ptr;
+  kFlagsOffset = 11 * ptr;
+  int64_t handle_size = 12 * ptr;
+
+  // uv__io_t: uv__io_cb cb; void* pending_queue[2]; void* watcher_queue[2];
+  // unsigned int pevents; unsigned int events; int fd;
+  int64_t io_watcher_fd = 5 * ptr + 8;
+  // write_queue_size, alloc_cb, read_cb, connect_req, shutdown_req
+  kStreamFdOffset = handle_size + 5 * ptr + io_watcher_fd;
+  // send_queue_size, send_queue_count, alloc_cb, recv_cb
+  kUdpFdOffset = handle_size + 4 * ptr + io_watcher_fd;
+  kPollFdOffset = handle_size + ptr + io_watcher_fd;
+
+  // uv_timer_cb timer_cb; void* heap_node[3]; uint64_t timeout;
+  // uint64_t repeat;
+  kTimerTimeoutOffset = handle_size + 4 * ptr;
+  kTimerRepeatOffset = kTimerTimeoutOffset + 8;
+
+  kReadSize = std::max(kStreamFdOffset, kUdpFdOffset) + 4;
+  kReadSize = std::max(kReadSize, kTimerRepeatOffset + 8);
+
+  kFirstType = 1;  // UV_ASYNC
+  kNamedPipeType = 7;
+  kPollType = 8;
+  kTCPType = 12;
+  kTimerType = 13;
+  kTTYType = 14;
+  kUDPType = 15;
+  kLastType = 17;  // UV_FILE
+
+  kClosingFlag = 0x1;
+  kClosedFlag = 0x2;
+  // libuv 1.20.0 merged the Unix and Windows handle flags. Before that,
+  // UV__HANDLE_ACTIVE and UV__HANDLE_REF were high bits on Unix. Cores whose
+  // libuv version can't be read are assumed to be newer.
+  int64_t version = LoadLibuvVersion(target_);
+  if (version >= 0 && version < 0x011400) {
+    kActiveFlag = 0x4000;
+    kRefFlag = 0x2000;
+  } else {
+    kActiveFlag = 0x4;
+    kRefFlag = 0x8;
+  }
+}
 }  // namespace constants
 }  // namespace node
 }  // namespace llnode
@@ -36,12 +36,14 @@ class Environment : public Module {
   int64_t kEnvContextEmbedderDataIndex;
   addr_t kCurrentEnvironment;
 
+  // Environment stored in the embedder data of a native context.
+  addr_t FromContext(v8::Context context, Error& err);
+
  protected:
   void Load();
 
  private:
   addr_t LoadCurrentEnvironment(Error& err);
-  addr_t CurrentEnvironmentFromContext(v8::Context context, Error& err);
 };
 
 class ReqWrapQueue : public Module {
@@ -95,6 +97,58 @@ class BaseObject : public Module {
  protected:
   void Load();
 };
+
+// libuv doesn't export postmortem metadata, but the public part of its
+// structs is stable across libuv 1.x and only depends on the pointer size.
+class UvLoop : public Module {
+ public:
+  NODE_CONSTANTS_DEFAULT_METHODS(UvLoop);
+
+  int64_t kPointerSize;
+  int64_t kActiveHandlesOffset;
+  int64_t kHandleQueueOffset;
+
+ protected:
+  void Load();
+};
+
+class UvHandle : public Module {
+ public:
+  NODE_CONSTANTS_DEFAULT_METHODS(UvHandle);
+
+  int64_t kLoopOffset;
+  int64_t kTypeOffset;
+  int64_t kHandleQueueOffset;
+  int64_t kFlagsOffset;
+  // uv_stream_t, uv_udp_t and uv_poll_t: io_watcher.fd
+  int64_t kStreamFdOffset;
+  int64_t kUdpFdOffset;
+  int64_t kPollFdOffset;
+  // uv_timer_t
+  int64_t kTimerTimeoutOffset;
+  int64_t kTimerRepeatOffset;
+  // Enough to decode any of the fields above
+  int64_t kReadSize;
+
+  // uv_handle_type
+  int64_t kFirstType;
+  int64_t kPollType;
+  int64_t kNamedPipeType;
+  int64_t kTCPType;
+  int64_t kTimerType;
+  int64_t kTTYType;
+  int64_t kUDPType;
+  int64_t kLastType;
+
+  // uv_handle_t.flags, from libuv's uv-common.h and unix/internal.h
+  int64_t kClosingFlag;
+  int64_t kClosedFlag;
+  int64_t kActiveFlag;
+  int64_t kRefFlag;
+
+ protected:
+  void Load();
+};
 }  // namespace constants
 }  // namespace node
 }  // namespace llnode
@@ -1,4 +1,10 @@
+#include <string.h>
+
+#include <map>
+#include <set>
+
 #include "node.h"
+#include "src/llv8-inl.h"
 
 namespace llnode {
 namespace node {
@@ -46,6 +52,223 @@ Environment Environment::GetCurrent(Node* node, Error& err) {
   return Environment(node, envAddr);
 }
 
+Environment Environment::FromContext(Node* node, v8::Context context,
+                                     Error& err) {
+  addr_t env_addr = node->env()->FromContext(context, err);
+  if (err.Success() && env_addr == 0) {
+    err = Error::Failure("Context has no Environment");
+  }
+
+  return Environment(node, env_addr);
+}
+
+std::vector<Environment> Environment::FromContexts(
+    Node* node, const std::unordered_set<uint64_t>& contexts) {
+  std::vector<Environment> environments;
+  std::set<addr_t> seen;
+
+  for (uint64_t raw : contexts) {
+    Error err;
+    v8::Context context(node->env()->llv8(), raw);
+    if (!context.IsNative(err) || err.Fail()) continue;
+
+    // vm contexts point at the Environment which created them as well.
+    Environment env = FromContext(node, context, err);
+    if (err.Fail() || !env.Check()) continue;
+    if (seen.insert(env.raw()).second) environments.push_back(env);
+  }
+
+  return environments;
+}
+
+bool Environment::Check() const {
+  if (raw_ == 0 || raw_ % node_->process().GetAddressByteSize() != 0)
+    return false;
+
+  // An empty queue points back at its head, a live one at its first item.
+  lldb::SBError sberr;
+  addr_t head = raw_ + node_->env()->kHandleWrapQueueOffset +
+                node_->handle_wrap_queue()->kHeadOffset;
+  addr_t next = node_->process().ReadPointerFromMemory(
+      head + node_->handle_wrap_queue()->kNextOffset, sberr);
+  return sberr.Success() && next != 0;
+}
+
+static uint64_t ReadWord(const uint8_t* data, int64_t size) {
+  if (size == 4) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+  }
+
+  uint64_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+addr_t Environment::FindLoop(Error& err) const {
+  constants::UvHandle* handle = node_->uv_handle();
+  int64_t ptr = node_->uv_loop()->kPointerSize;
+  lldb::SBProcess process = node_->process();
+
+  // The Environment embeds its timer, immediate and async handles, read the
+  // beginning of it at once and look for them.
+  std::vector<uint8_t> data(8192);
+  lldb::SBError sberr;
+  size_t read = process.ReadMemory(raw_, data.data(), data.size(), sberr);
+  if (sberr.Fail()) {
+    read = process.ReadMemory(raw_, data.data(), 1024, sberr);
+  }
+  if (sberr.Fail() || read == 0) {
+    err = Error::Failure("Failed to read the Environment");
+    return 0;
+  }
+
+  std::map<addr_t, int> votes;
+  for (size_t off = 0; off + handle->kFlagsOffset + ptr <= read; off += ptr) {
+    const uint8_t* h = &data[off];
+    addr_t loop = ReadWord(h + handle->kLoopOffset, ptr);
+    int64_t type = ReadWord(h + handle->kTypeOffset, 4);
+    if (loop == 0 || loop % ptr != 0 || type < handle->kFirstType ||
+        type > handle->kLastType) {
+      continue;
+    }
+
+    addr_t queue = raw_ + off + handle->kHandleQueueOffset;
+    addr_t next = ReadWord(h + handle->kHandleQueueOffset, ptr);
+    addr_t prev = ReadWord(h + handle->kHandleQueueOffset + ptr, ptr);
+    if (next == 0 || prev == 0) continue;
+
+    // A queued handle is linked from both of its neighbours.
+    if (process.ReadPointerFromMemory(next + ptr, sberr) != queue ||
+        sberr.Fail()) {
+      continue;
+    }
+    if (process.ReadPointerFromMemory(prev, sberr) != queue || sberr.Fail())
+      continue;
+
+    votes[loop]++;
+  }
+
+  addr_t loop = 0;
+  int best = 0;
+  for (auto& vote : votes) {
+    if (vote.second > best) {
+      loop = vote.first;
+      best = vote.second;
+    }
+  }
+
+  if (loop == 0) err = Error::Failure("Couldn't find the Environment's loop");
+  return loop;
+}
+
+const char* UvHandle::TypeName(int64_t type) {
+  // uv_handle_type, in declaration order
+  static const char* names[] = {
+      "UNKNOWN", "ASYNC",   "CHECK",  "FS_EVENT", "FS_POLL", "HANDLE",
+      "IDLE",    "NAMED_PIPE", "POLL", "PREPARE", "PROCESS", "STREAM",
+      "TCP",     "TIMER",   "TTY",    "UDP",      "SIGNAL",  "FILE"};
+  if (type < 0 || type >= static_cast<int64_t>(sizeof(names) / sizeof(*names)))
+    return "UNKNOWN";
+  return names[type];
+}
+
+UvLoop UvLoop::GetDefault(Node* node, Error& err) {
+  lldb::SBTarget target = node->process().GetTarget();
+  lldb::SBSymbolContextList contexts =
+      target.FindSymbols("default_loop_struct");
+
+  for (uint32_t i = 0; i < contexts.GetSize(); i++) {
+    lldb::SBSymbol symbol = contexts.GetContextAtIndex(i).GetSymbol();
+    addr_t addr = symbol.GetStartAddress().GetLoadAddress(target);
+    if (addr != LLDB_INVALID_ADDRESS) return UvLoop(node, addr);
+  }
+
+  err = Error::Failure("Couldn't find libuv's default loop");
+  return UvLoop(node, 0);
+}
+
+uint32_t UvLoop::ActiveHandles(Error& err) {
+  lldb::SBError sberr;
+  uint32_t count = node_->process().ReadUnsignedFromMemory(
+      raw_ + node_->uv_loop()->kActiveHandlesOffset, 4, sberr);
+  if (sberr.Fail()) {
+    err = Error::Failure("Failed to read the loop's active handles");
+    return 0;
+  }
+  return count;
+}
+
+std::vector<UvHandle> UvLoop::Handles(Error& err) {
+  // Guards against a corrupted queue which doesn't lead back to its head.
+  static const size_t kMaxHandles = 1 << 22;
+
+  constants::UvHandle* constants = node_->uv_handle();
+  int64_t ptr = node_->uv_loop()->kPointerSize;
+  lldb::SBProcess process = node_->process();
+  lldb::SBError sberr;
+
+  std::vector<UvHandle> handles;
+  addr_t head = raw_ + node_->uv_loop()->kHandleQueueOffset;
+  addr_t current = process.ReadPointerFromMemory(head, sberr);
+  if (sberr.Fail()) {
+    err = Error::Failure("Failed to read the loop's handle queue");
+    return handles;
+  }
+
+  std::vector<uint8_t> data(constants->kReadSize);
+  while (current != head && handles.size() < kMaxHandles) {
+    UvHandle handle;
+    handle.raw = current - constants->kHandleQueueOffset;
+
+    // The next queue node is read along with the handle, one request per hop.
+    size_t read =
+        process.ReadMemory(handle.raw, data.data(), data.size(), sberr);
+    if (sberr.Fail()) {
+      // Smaller handles may end right before an unmapped page.
+      read = process.ReadMemory(handle.raw, data.data(),
+                                constants->kFlagsOffset + 4, sberr);
+    }
+    if (sberr.Fail()) {
+      err = Error::Failure("Failed to read uv handle at 0x%016" PRIx64,
+                           handle.raw);
+      return handles;
+    }
+
+    handle.type = ReadWord(&data[constants->kTypeOffset], 4);
+    handle.flags = ReadWord(&data[constants->kFlagsOffset], 4);
+    handle.fd = -1;
+    handle.timeout = 0;
+    handle.repeat = 0;
+
+    int64_t fd_offset = -1;
+    if (handle.type == constants->kTCPType ||
+        handle.type == constants->kNamedPipeType ||
+        handle.type == constants->kTTYType) {
+      fd_offset = constants->kStreamFdOffset;
+    } else if (handle.type == constants->kUDPType) {
+      fd_offset = constants->kUdpFdOffset;
+    } else if (handle.type == constants->kPollType) {
+      fd_offset = constants->kPollFdOffset;
+    }
+    if (fd_offset != -1 && fd_offset + 4 <= static_cast<int64_t>(read)) {
+      handle.fd = static_cast<int32_t>(ReadWord(&data[fd_offset], 4));
+    }
+
+    if (handle.type == constants->kTimerType &&
+        constants->kTimerRepeatOffset + 8 <= static_cast<int64_t>(read)) {
+      handle.timeout = ReadWord(&data[constants->kTimerTimeoutOffset], 8);
+      handle.repeat = ReadWord(&data[constants->kTimerRepeatOffset], 8);
+    }
+
+    handles.push_back(handle);
+    current = ReadWord(&data[constants->kHandleQueueOffset], ptr);
+  }
+
+  return handles;
+}
+
 HandleWrapQueue Environment::handle_wrap_queue() const {
   return HandleWrapQueue(node_, raw_ + node_->env()->kHandleWrapQueueOffset,
                          node_->handle_wrap_queue());
@@ -71,6 +294,8 @@ void Node::Load(SBTarget target) {
   handle_wrap_queue.Assign(target);
   handle_wrap.Assign(target);
   base_object.Assign(target);
+  uv_loop.Assign(target);
+  uv_handle.Assign(target);
 }
 }  // namespace node
 }  // namespace llnode
@@ -3,6 +3,8 @@
 
 #include <lldb/API/LLDB.h>
 #include <list>
+#include <unordered_set>
+#include <vector>
 
 #include "node-constants.h"
 
@@ -12,7 +14,9 @@
   V(ReqWrap, req_wrap)                  \
   V(HandleWrapQueue, handle_wrap_queue) \
   V(HandleWrap, handle_wrap)            \
-  V(BaseObject, base_object)
+  V(BaseObject, base_object)            \
+  V(UvLoop, uv_loop)                    \
+  V(UvHandle, uv_handle)
 
 namespace llnode {
 namespace node {
@@ -40,6 +44,18 @@ class Environment : public BaseNode {
   inline addr_t raw() { return raw_; };
 
   static Environment GetCurrent(Node* node, Error& err);
+  static Environment FromContext(Node* node, v8::Context context, Error& err);
+  // Every Environment reachable from the native contexts among contexts,
+  // e.g. the main thread's and those of worker_threads, each once.
+  static std::vector<Environment> FromContexts(
+      Node* node, const std::unordered_set<uint64_t>& contexts);
+
+  // Whether raw looks like a live Environment
+  bool Check() const;
+
+  // The uv_loop_t this Environment runs on, found through the libuv handles
+  // embedded in it.
+  addr_t FindLoop(Error& err) const;
 
   HandleWrapQueue handle_wrap_queue() const;
   ReqWrapQueue req_wrap_queue() const;
@@ -79,6 +95,35 @@ class ReqWrap : public AsyncWrap {
   static ReqWrap GetItemFromList(Node* node, addr_t list_node_addr);
 };
 
+struct UvHandle {
+  addr_t raw;
+  int64_t type;
+  int64_t flags;
+  // -1 for handles without a file descriptor
+  int64_t fd;
+  // Timers only, in the loop's clock (milliseconds)
+  uint64_t timeout;
+  uint64_t repeat;
+
+  static const char* TypeName(int64_t type);
+};
+
+class UvLoop : public BaseNode {
+ public:
+  UvLoop(Node* node, addr_t raw) : BaseNode(node), raw_(raw){};
+  inline addr_t raw() { return raw_; };
+
+  // uv_default_loop()
+  static UvLoop GetDefault(Node* node, Error& err);
+
+  uint32_t ActiveHandles(Error& err);
+  // Every handle in the loop's handle queue, each read in a single request.
+  std::vector<UvHandle> Handles(Error& err);
+
+ private:
+  addr_t raw_;
+};
+
 class Node {
  public:
 #define V(Class, Attribute) Attribute(constants::Class(llv8)),
@@ -88,6 +133,8 @@ class Node {
   inline lldb::SBProcess process() { return process_; };
 
   void Load(lldb::SBTarget target);
+  // Forget the loaded constants, the next Load() reads them again.
+  void Unload() { target_ = lldb::SBTarget(); }
 
 #define V(Class, Attribute) constants::Class Attribute;
   CONSTANTS_LIST(V)
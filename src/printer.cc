@@ -74,7 +74,31 @@ std::string Printer::Stringify(v8::JSFrame js_frame, Error& err) {
 
   char tmp[128];
   snprintf(tmp, sizeof(tmp), " fn=0x%016" PRIx64, fn.raw());
-  return fn.GetDebugLine(args, err) + tmp;
+  std::string res = GetDebugLine(fn, args, err);
+  if (err.Fail()) return std::string();
+  return res + tmp;
+}
+
+
+std::string Printer::GetDebugLine(v8::JSFunction fn, std::string args,
+                                  Error& err) {
+  if (debug_lines_ == nullptr) return fn.GetDebugLine(args, err);
+
+  auto it = debug_lines_->find(fn.raw());
+  if (it == debug_lines_->end()) {
+    std::string name = fn.Name(err);
+    if (err.Fail()) return std::string();
+
+    std::string postfix = fn.Info(err).GetPostfix(err);
+    if (err.Fail()) return std::string();
+
+    it = debug_lines_->emplace(fn.raw(), std::make_pair(name, postfix)).first;
+  }
+
+  // Same output as JSFunction::GetDebugLine()
+  std::string res = it->second.first;
+  if (!args.empty()) res += "(" + args + ")";
+  return res + " at " + it->second.second;
 }
 
 
@@ -624,6 +648,58 @@ std::string Printer::Stringify(v8::JSArray js_array, Error& err) {
 }
 
 
+template <>
+std::string Printer::Stringify(v8::JSCollection collection, Error& err) {
+  v8::JSCollection::Kind kind = collection.GetKind(err);
+  if (err.Fail()) return std::string();
+
+  int64_t size = collection.Size(err);
+  if (err.Fail()) return std::string();
+
+  std::string res = std::string("<JS") + v8::JSCollection::KindName(kind) +
+                    ": size=" + std::to_string(size);
+
+  if (!options_.detailed) {
+    std::stringstream ss;
+    ss << rang::fg::yellow << res + ">" << rang::fg::reset;
+    return ss.str();
+  }
+
+  std::vector<std::pair<v8::Value, v8::Value>> entries =
+      collection.CollectionEntries(err);
+  if (err.Fail()) return std::string();
+
+  std::stringstream ss;
+  ss << rang::fg::magenta << res << rang::fg::reset;
+  res = ss.str();
+
+  Printer printer(llv8_);
+  size_t display_length = std::min<size_t>(entries.size(), options_.length);
+  std::string elems;
+  for (size_t i = 0; i < display_length; i++) {
+    if (!elems.empty()) elems += ",\n";
+
+    ss.str("");
+    ss.clear();
+    ss << rang::style::bold << rang::fg::yellow << "    [" << i << "]"
+       << rang::fg::reset << rang::style::reset << "=";
+    elems += ss.str();
+
+    elems += printer.Stringify(entries[i].first, err);
+    if (err.Fail()) return std::string();
+
+    if (entries[i].second.Check()) {
+      elems += " => " + printer.Stringify(entries[i].second, err);
+      if (err.Fail()) return std::string();
+    }
+  }
+  if (display_length < entries.size()) elems += ",\n    ...";
+
+  if (!elems.empty()) res += " {\n" + elems + "}";
+  return res + ">";
+}
+
+
 template <>
 std::string Printer::Stringify(v8::JSRegExp regexp, Error& err) {
   if (llv8_->js_regexp()->kSourceOffset == -1)
@@ -762,6 +838,11 @@ std::string Printer::Stringify(v8::HeapObject heap_object, Error& err) {
     return pre + Stringify(date, err);
   }
 
+  if (v8::JSCollection::IsCollectionType(llv8_, type)) {
+    v8::JSCollection collection(heap_object);
+    return pre + Stringify(collection, err);
+  }
+
   PRINT_DEBUG("Unknown HeapObject Type %" PRId64 " at 0x%016" PRIx64 "", type,
               heap_object.raw());
 
@@ -786,36 +867,12 @@ std::string Printer::Stringify(v8::Value value, Error& err) {
 
 std::string Printer::StringifyInternalFields(v8::JSObject js_object,
                                              Error& err) {
-  v8::HeapObject map_obj = js_object.GetMap(err);
-  if (err.Fail()) return std::string();
-
-  v8::Map map(map_obj);
-  int64_t type = map.GetType(err);
-  if (err.Fail()) return std::string();
-
-  // Only v8::JSObject for now
-  if (!v8::JSObject::IsObjectType(llv8_, type)) return std::string();
-
-  int64_t instance_size = map.InstanceSize(err);
-
-  // kVariableSizeSentinel == 0
-  // TODO(indutny): post-mortem constant for this?
-  if (err.Fail() || instance_size == 0) return std::string();
-
-  int64_t in_object_props = map.InObjectProperties(err);
+  std::vector<int64_t> fields = js_object.InternalFields(err);
   if (err.Fail()) return std::string();
 
-  // in-object properties are appended to the end of the v8::JSObject,
-  // skip them.
-  instance_size -= in_object_props * llv8_->common()->kPointerSize;
-
   std::string res;
   std::stringstream ss;
-  for (int64_t off = llv8_->js_object()->kInternalFieldsOffset;
-       off < instance_size; off += llv8_->common()->kPointerSize) {
-    int64_t field = js_object.LoadField(off, err);
-    if (err.Fail()) return std::string();
-
+  for (int64_t field : fields) {
     char tmp[128];
     snprintf(tmp, sizeof(tmp), "    0x%016" PRIx64, field);
 
@@ -2,6 +2,8 @@
 #define SRC_INSPECT_H_
 
 #include <string>
+#include <unordered_map>
+#include <utility>
 
 #include <lldb/API/LLDB.h>
 
@@ -37,9 +39,17 @@ class Printer {
     bool with_args;
   };
 
-  Printer(v8::LLV8* llv8) : llv8_(llv8), options_(){};
+  // JSFunction address -> name and location of its debug line. Shared by the
+  // frames of a backtrace, so each function is decoded only once.
+  typedef std::unordered_map<int64_t, std::pair<std::string, std::string>>
+      DebugLineCache;
+
+  Printer(v8::LLV8* llv8) : llv8_(llv8), options_(), debug_lines_(nullptr){};
   Printer(v8::LLV8* llv8, const PrinterOptions options)
-      : llv8_(llv8), options_(options){};
+      : llv8_(llv8), options_(options), debug_lines_(nullptr){};
+  Printer(v8::LLV8* llv8, const PrinterOptions options,
+          DebugLineCache* debug_lines)
+      : llv8_(llv8), options_(options), debug_lines_(debug_lines){};
 
   template <typename T, typename Actual = T>
   std::string Stringify(T value, Error& err);
@@ -66,8 +76,11 @@ class Printer {
                             Error& err);
 
  private:
+  std::string GetDebugLine(v8::JSFunction fn, std::string args, Error& err);
+
   v8::LLV8* llv8_;
   const PrinterOptions options_;
+  DebugLineCache* debug_lines_;
 };
 
 }  // namespace llnode
@@ -1,6 +1,6 @@
 'use strict';
 
-const fromCoredump = require('../../').fromCoredump;
+const { collapseStacks, fromCoredump } = require('../../');
 
 const debug = process.env.TEST_LLNODE_DEBUG ?
   console.log.bind(console) : () => { };
@@ -28,6 +28,69 @@ tape('llnode API', (t) => {
   }
 });
 
+tape('llnode API: scanHeap', (t) => {
+  t.timeoutAfter(common.saveCoreTimeout);
+
+  // The previous test saved the core
+  const core = process.env.LLNODE_CORE || common.core;
+  const executable = process.env.LLNODE_NODE_EXE || process.execPath;
+
+  const cancelled = fromCoredump(core, executable);
+  const cancelledScan = cancelled.scanHeap();
+  t.ok(cancelled.cancelScan(), 'cancelScan should stop a running scan');
+  t.throws(() => cancelled.getHeapTypes(), /heap scan is in progress/,
+    'the API should not be used while a scan runs');
+
+  cancelledScan.then(() => {
+    t.fail('a cancelled scan should reject');
+  }, (err) => {
+    t.ok(/cancelled/.test(err.message), 'a cancelled scan should reject');
+    return rescan();
+  }).then(scan).then(scanConcurrently).then(() => t.end(), (err) => t.end(err));
+
+  // Scanning again after a cancelled scan shouldn't count anything twice
+  function rescan() {
+    return cancelled.scanHeap().then(() => {
+      const fresh = fromCoredump(core, executable);
+      const spaces = fresh.getHeapSpaces();
+      t.ok(spaces.some((space) => space.pages > 0),
+        'getHeapSpaces should find heap pages');
+      t.deepEqual(cancelled.getHeapSpaces(), spaces,
+        'heap spaces should be the same after a cancelled scan');
+    });
+  }
+
+  function scan() {
+    const llnode = fromCoredump(core, executable);
+    let lastScanned = 0;
+    let increasing = true;
+    return llnode.scanHeap((scanned, total) => {
+      increasing = increasing && scanned >= lastScanned && scanned <= total;
+      lastScanned = scanned;
+    }).then((heapTypes) => {
+      t.ok(lastScanned > 0, 'scanHeap should report its progress');
+      t.ok(increasing, 'progress should increase up to the total');
+      t.ok(heapTypes.some((type) => type.typeName === 'process'),
+        'scanHeap should resolve with the heap types');
+      t.equal(llnode.getHeapTypes().length, heapTypes.length,
+        'getHeapTypes should reuse the scan');
+    });
+  }
+
+  // Independent instances scan on different threads at the same time
+  function scanConcurrently() {
+    const instances = [0, 1, 2].map(() => fromCoredump(core, executable));
+    return Promise.all(instances.map((llnode) => llnode.scanHeap()))
+      .then((results) => {
+        const counts = results.map((heapTypes) => heapTypes.reduce(
+          (count, type) => count + type.instanceCount, 0));
+        t.ok(counts[0] > 0, 'concurrent scans should find objects');
+        t.ok(counts.every((count) => count === counts[0]),
+          'concurrent scans of the same core should agree');
+      });
+  }
+});
+
 function test(executable, core, t) {
   debug('============= Loading ==============');
   // Equivalent to lldb executable -c core
@@ -38,6 +101,57 @@ function test(executable, core, t) {
   const typeMap = verifyBasicTypes(llnode, t);
   const processType = verifyProcessType(typeMap, llnode, t);
   verifyProcessInstances(processType, llnode, t);
+  verifyInstanceAddresses(processType, llnode, t);
+  verifyObjectInfo(processType, llnode, t);
+  verifyObjectInfoKinds(llnode, t);
+  verifyCollapseStacks(executable, core, t);
+}
+
+function verifyObjectInfoKinds(llnode, t) {
+  const type = llnode.getHeapTypes().find(
+    (type) => type.typeName === 'Class_D');
+  t.ok(type, 'Class_D should be in the heap');
+  const info = llnode.getObjectInfo(type.getInstanceAddresses()[0]);
+  const property = (object, name) => llnode.getObjectInfo(
+    object.properties.values[object.properties.keys.indexOf(name)]);
+
+  const point = property(info, 'point');
+  debug('Point info', point);
+  const x = point.properties.doubleKeys.indexOf('x');
+  t.ok(x !== -1 || point.properties.keys.includes('x'),
+    'double fields should not be left out');
+  if (x !== -1) {
+    t.equal(point.properties.doubleValues[x], 1.5,
+      'double fields should be decoded');
+  }
+
+  const doubles = property(info, 'doubles');
+  debug('Doubles info', doubles);
+  if (doubles.elementsKind === 'double') {
+    t.deepEqual(Array.from(doubles.doubleElements), [1.5, 2.5],
+      'double elements should be numbers, up to the array length');
+    t.equal(doubles.elements.length, 0,
+      'double elements should not be read as tagged values');
+  } else {
+    t.equal(doubles.elements.length, 2,
+      'elements should stop at the array length');
+  }
+
+  const sparse = property(info, 'sparse');
+  t.equal(sparse.elementsKind, 'dictionary',
+    'sparse arrays should have dictionary elements');
+  t.equal(sparse.elements.length, 0,
+    'dictionary elements should not be read as tagged values');
+}
+
+function verifyCollapseStacks(executable, core, t) {
+  const folded = collapseStacks([core, core], executable).trim().split('\n');
+  debug('Folded stacks', folded);
+  t.ok(folded.length > 0, 'collapseStacks should return stacks');
+  t.ok(folded.every((line) => / \d+$/.test(line)),
+    'every folded stack should end with a count');
+  t.ok(folded.every((line) => parseInt(line.match(/ (\d+)$/)[1]) % 2 === 0),
+    'stacks of the same core twice should be counted twice');
 }
 
 function verifySBProcess(llnode, t) {
@@ -149,3 +263,51 @@ function verifyProcessInstances(processType, llnode, t) {
   }
   t.ok(foundProcess, 'should find the process object');
 }
+
+function verifyInstanceAddresses(processType, llnode, t) {
+  const addresses = processType.getInstanceAddresses();
+  t.ok(addresses instanceof BigUint64Array,
+    'getInstanceAddresses should return a BigUint64Array');
+  t.equal(addresses.length, processType.instanceCount,
+    'getInstanceAddresses should return every instance');
+  t.equal(processType.getInstanceAddresses(), addresses,
+    'getInstanceAddresses should return the same array on later calls');
+
+  const values = llnode.getObjects(addresses);
+  t.equal(values.length, addresses.length,
+    'getObjects should decode every address');
+  addresses.forEach((address, i) => {
+    const hex = '0x' + address.toString(16).padStart(16, '0');
+    t.equal(values[i], llnode.getObjectAtAddress(hex).value,
+      'getObjects should match getObjectAtAddress');
+  });
+}
+
+function verifyObjectInfo(processType, llnode, t) {
+  const infos = Array.from(processType.getInstanceAddresses(),
+    (address) => llnode.getObjectInfo(address));
+  const info = infos.find((info) => info.properties.keys.includes('argv'));
+  t.ok(info, 'getObjectInfo should decode the process object');
+  debug('Process object info', info);
+  t.equal(info.kind, 'object', 'process should be an object');
+  t.equal(info.type, 'process', 'process should have its type name');
+  t.equal(typeof info.map, 'bigint', 'the map should be a BigInt');
+  t.equal(info.properties.keys.length, info.properties.values.length,
+    'every property should have a value');
+
+  const property = (name) => llnode.getObjectInfo(
+    info.properties.values[info.properties.keys.indexOf(name)]);
+
+  const pid = property('pid');
+  t.equal(pid.kind, 'smi', 'process.pid should be a Smi');
+  t.ok(pid.value > 0, 'process.pid should be decoded');
+
+  const platform = property('platform');
+  t.equal(platform.kind, 'string', 'process.platform should be a string');
+  t.equal(platform.value, process.platform, 'process.platform should match');
+
+  const argv = property('argv');
+  t.ok(argv.elements.length > 0, 'process.argv should have elements');
+  t.equal(llnode.getObjectInfo(argv.elements[0]).kind, 'string',
+    'process.argv elements should be strings');
+}
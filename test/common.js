@@ -160,7 +160,11 @@ function Session(options) {
   EventEmitter.call(this);
   const timeout = parseInt(process.env.TEST_TIMEOUT) || 10000;
   const lldbBin = process.env.TEST_LLDB_BINARY || 'lldb';
-  const env = Object.assign({}, process.env);
+  const env = Object.assign({}, process.env, options.env);
+  // Allow sessions to unset variables of the test runner
+  for (const name of Object.keys(env)) {
+    if (env[name] === undefined) delete env[name];
+  }
 
   debug('lldb binary:', lldbBin);
   if (options.scenario) {
@@ -278,11 +282,13 @@ exports.saveCore = function saveCore(options, cb) {
   }
 }
 
-// Load the core dump with the executable
-Session.loadCore = function loadCore(executable, core, cb) {
+// Load the core dump with the executable, env is added to the environment of
+// lldb.
+Session.loadCore = function loadCore(executable, core, cb, env) {
   const sess = new Session({
     executable: executable,
-    core: core
+    core: core,
+    env: env
   });
 
   sess.timeoutAfter(exports.loadCoreTimeout);
@@ -0,0 +1,14 @@
+'use strict';
+
+const common = require('../common');
+
+// Baseline of v8 heapdiff, scan-scenario.js creates the same objects and
+// more on top of them.
+function Baseline() {
+}
+
+Baseline.prototype.method = function method() {
+  throw new Error('Uncaught');
+};
+
+new Baseline().method();
@@ -82,6 +82,10 @@ function closure() {
   c.hashmap['date_1'] = new Date('2000-01-01');
   c.hashmap['date_2'] = new Date(1);
 
+  c.hashmap['map'] = new Map([['a', 1], ['b', 2], ['c', 3]]);
+  c.hashmap['map'].delete('b');
+  c.hashmap['set'] = new Set([1, 2, 3]);
+
   exports.holder = scopedAPI;
 
   c.hashmap.scoped = function name() {
@@ -102,6 +106,17 @@ function closure() {
 
   let classC = new Class_C(arr);
 
+  // Elements and fields which aren't tagged values
+  function Class_D() {
+    this.point = { x: 1.5, y: 2.5 };
+    this.doubles = [1.5, 2.5, 3.5];
+    this.doubles.length = 2;
+    this.sparse = [];
+    this.sparse[100000] = 'sparse';
+  }
+
+  let classD = new Class_D();
+
   c.method();
 }
 
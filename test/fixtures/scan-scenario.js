@@ -8,6 +8,45 @@ let outerVar = 'outer variable';
 
 exports.holder = {};
 
+// Concatenate the same string at runtime so that the copies are cons strings
+// instead of internalized ones.
+exports.duplicates = [];
+const words = ['duplicated', 'string', 'value'];
+for (let i = 0; i < 10; i++)
+  exports.duplicates.push(words[0] + ' ' + words[1] + ' ' + words[2]);
+
+// One off-heap ArrayBuffer with two views on it.
+const arrayBuffer = new ArrayBuffer(1024 * 1024);
+exports.views = [ new Uint8Array(arrayBuffer), new Uint32Array(arrayBuffer) ];
+
+// A Map larger than any of the ones node creates at startup.
+exports.cache = new Map();
+for (let i = 0; i < 5000; i++)
+  exports.cache.set(i, i);
+
+// Ten promises chained on one which never settles, and an async function
+// suspended on the last of them.
+let chained = new Promise(() => {});
+for (let i = 0; i < 10; i++)
+  chained = chained.then(() => {});
+async function waitForChain() {
+  await chained;
+}
+exports.waiting = waitForChain();
+
+// Deleting a property which wasn't the last one added turns an object into
+// dictionary mode.
+function Dictionary() {
+  this.a = 1;
+  this.b = 2;
+}
+exports.dictionaries = [];
+for (let i = 0; i < 10; i++) {
+  const obj = new Dictionary();
+  delete obj.a;
+  exports.dictionaries.push(obj);
+}
+
 function makeThin(a, b) {
   var str = a + b;
   var obj = {};
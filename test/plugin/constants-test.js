@@ -0,0 +1,187 @@
+'use strict';
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const tape = require('tape');
+
+const common = require('../common');
+const versionMark = common.versionMark;
+
+tape('v8 settings constants', (t) => {
+  t.timeoutAfter(common.saveCoreTimeout);
+
+  // Use prepared core and executable to test
+  if (process.env.LLNODE_CORE && process.env.LLNODE_NODE_EXE) {
+    test(process.env.LLNODE_NODE_EXE, process.env.LLNODE_CORE, t);
+  } else {
+    common.saveCore({
+      scenario: 'inspect-scenario.js'
+    }, (err) => {
+      t.error(err);
+      t.ok(true, 'Saved core');
+
+      test(process.execPath, common.core, t);
+    });
+  }
+});
+
+function readProfile(file) {
+  const profile = { buildId: null, loaded: new Map(), defaults: new Set() };
+  for (const line of fs.readFileSync(file, 'utf8').split('\n')) {
+    const fields = line.split(' ');
+    if (fields[0] === 'build-id')
+      profile.buildId = fields[1];
+    else if (fields[0] === 'loaded')
+      profile.loaded.set(fields[1], fields[2]);
+    else if (fields[0] === 'default')
+      profile.defaults.add(fields[1]);
+  }
+  return profile;
+}
+
+function sameLoaded(a, b) {
+  if (a.loaded.size !== b.loaded.size) return false;
+  for (const [name, value] of a.loaded) {
+    if (b.loaded.get(name) !== value) return false;
+  }
+  return true;
+}
+
+// Run `commands` in a new session, calls back with the lines printed on
+// stdout and stderr.
+function run(executable, core, env, commands, t, callback) {
+  const stderr = [];
+  const sess = common.Session.loadCore(executable, core, (err) => {
+    t.error(err);
+    for (const command of commands) sess.send(command);
+    // Just a separator
+    sess.send('version');
+  }, env);
+  sess.stderr.on('line', (line) => stderr.push(line));
+
+  sess.linesUntil(versionMark, (err, lines) => {
+    t.error(err);
+    sess.quit();
+    callback(lines.join('\n'), stderr.join('\n'));
+  });
+}
+
+function tmpdir(name) {
+  return fs.mkdtempSync(path.join(os.tmpdir(), `llnode-${name}-`));
+}
+
+function test(executable, core, t) {
+  const cacheDir = tmpdir('profiles');
+  const indexedFile = path.join(cacheDir, 'indexed.profile');
+
+  run(executable, core, { LLNODE_PROFILE_DIR: cacheDir },
+      ['v8 bt', `v8 settings constants export ${indexedFile}`], t,
+      (output) => {
+    t.ok(/Exported \d+ loaded and \d+ default constants/.test(output),
+         'export should print the number of constants');
+    const indexed = readProfile(indexedFile);
+    t.ok(indexed.buildId, 'exported profile should have a build-id');
+    t.ok(indexed.defaults.size > 0,
+         'exported profile should have the missing constants');
+
+    const cachedFile = path.join(cacheDir, `${indexed.buildId}.profile`);
+    t.ok(fs.existsSync(cachedFile), 'profile should be cached');
+    const cached = readProfile(cachedFile);
+    t.ok(sameLoaded(cached, indexed) &&
+             cached.defaults.size === indexed.defaults.size,
+         'cached profile should have the constants looked up by v8 bt');
+
+    testImport(executable, core, t, output, indexed, indexedFile);
+  });
+}
+
+// Import before anything else is loaded, a new session should use the
+// profile instead of walking the symbol tables and print the same stack.
+function testImport(executable, core, t, btOutput, indexed, indexedFile) {
+  const cacheDir = tmpdir('profiles');
+  const roundTripFile = path.join(cacheDir, 'round-trip.profile');
+
+  run(executable, core, { LLNODE_PROFILE_DIR: cacheDir, LLNODE_DEBUG: 'true' },
+      [`v8 settings constants import ${indexedFile}`, 'v8 bt',
+       `v8 settings constants export ${roundTripFile}`], t,
+      (output, stderr) => {
+    t.ok(new RegExp(`Imported ${indexed.loaded.size} loaded`).test(output),
+         'import should load every constant of the profile');
+    t.notOk(/Indexed \d+ postmortem symbols/.test(stderr),
+            'import should not walk the symbol tables');
+    t.ok(fs.existsSync(path.join(cacheDir, `${indexed.buildId}.profile`)),
+         'import should keep the profile for later sessions');
+
+    const frames = (text) => text.match(/frame #\d+:.*/g);
+    t.deepEqual(frames(output), frames(btOutput),
+                'v8 bt should be the same with the imported profile');
+    t.ok(sameLoaded(readProfile(roundTripFile), indexed),
+         'profile should survive an import and export round-trip');
+
+    testNoCache(executable, core, t, btOutput, indexed, indexedFile);
+  });
+}
+
+// Without a profile directory, sessions shouldn't write to $HOME.
+function testNoCache(executable, core, t, btOutput, indexed, indexedFile) {
+  const home = tmpdir('home');
+
+  run(executable, core, { HOME: home, LLNODE_PROFILE_DIR: undefined },
+      ['v8 bt', 'v8 bt'], t, () => {
+    t.notOk(fs.existsSync(path.join(home, '.llnode')),
+            'profiles should not be cached unless the directory exists');
+
+    testWithoutIndex(executable, core, t, btOutput, indexed, indexedFile);
+  });
+}
+
+// Searching the symbol tables for each constant should resolve everything
+// the same as the index, present and missing constants alike.
+function testWithoutIndex(executable, core, t, btOutput, indexed,
+                          indexedFile) {
+  const plainFile = path.join(tmpdir('profiles'), 'plain.profile');
+
+  run(executable, core, { LLNODE_SYMBOL_INDEX: '0' },
+      ['v8 bt', `v8 settings constants export ${plainFile}`], t,
+      (output) => {
+    const plain = readProfile(plainFile);
+
+    const present = [...plain.loaded.keys()].filter(
+        (name) => name.startsWith('v8dbg_'));
+    t.ok(present.length > 0, 'should look up present v8dbg_ constants');
+    t.ok(present.every(
+             (name) => indexed.loaded.get(name) === plain.loaded.get(name)),
+         'present constants should have the same value with the index');
+
+    const missing = [...plain.defaults].filter(
+        (name) => name.startsWith('v8dbg_'));
+    t.ok(missing.length > 0, 'should look up missing v8dbg_ constants');
+    t.ok(missing.every((name) => !indexed.loaded.has(name) &&
+                                 indexed.defaults.has(name)),
+         'missing constants should be missing with the index');
+
+    const frames = (text) => text.match(/frame #\d+:.*/g);
+    t.deepEqual(frames(output), frames(btOutput),
+                'v8 bt should be the same without the index');
+
+    testTruncated(executable, core, t, indexedFile);
+  });
+}
+
+// A profile cut short (e.g. by a crash while saving it) isn't used.
+function testTruncated(executable, core, t, indexedFile) {
+  const lines = fs.readFileSync(indexedFile, 'utf8').trim().split('\n');
+  t.equal(lines[lines.length - 1], 'end', 'profiles should end with "end"');
+  const truncatedFile = path.join(tmpdir('profiles'), 'truncated.profile');
+  fs.writeFileSync(truncatedFile, lines.slice(0, -2).join('\n') + '\n');
+
+  run(executable, core, {},
+      [`v8 settings constants import ${truncatedFile}`], t,
+      (output, stderr) => {
+    t.notOk(/Imported/.test(output), 'truncated profiles should be rejected');
+    t.ok(/is incomplete/.test(stderr),
+         'import should say the profile is incomplete');
+    t.end();
+  });
+}
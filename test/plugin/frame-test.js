@@ -133,6 +133,18 @@ tape('v8 stack', async (t) => {
       fatalError(t, sess, "Couldn't determine fnInferredName's frame number");
     }
 
+    sess.send('v8 bt --all');
+    lines = await sess.linesUntil(/\sfnFunctionName\(/);
+    t.ok(lines.some((line) => /^\s\*\sthread #\d+/.test(line)),
+         'selected thread in v8 bt --all');
+    t.ok(lines.some((line) => /crasher/.test(line)),
+         'crasher frame in v8 bt --all');
+
+    sess.send('v8 stackcollapse');
+    lines = await sess.linesUntil(/crasher/);
+    t.ok(/fnFunctionName.*;.*crasher.* \d+$/.test(lines[lines.length - 1]),
+         'folded stack of the main thread');
+
     sess.quit();
     return t.end();
   } catch (err) {
@@ -383,6 +383,36 @@ const hashMapTests = {
   'date_2' : {
     re: /\.date_2=0x[0-9a-f]+:<JSDate: 1>/,
     desc: ".date_2 JSDate element",
+  },
+  // .map=0x000003df9cbe8231:<JSMap: size=2>
+  'map': {
+    re: /\.map=(0x[0-9a-f]+):<(?:JSMap: size=2|unknown)>/,
+    desc: '.map JSMap property',
+    validator(t, sess, addresses, name, cb) {
+      sess.hasSymbol('v8dbg_type_JSMap__JS_MAP_TYPE', (err, hasSymbol) => {
+        if (err) return cb(err);
+        if (!hasSymbol) {
+          t.skip('no metadata for JSMap type');
+          return cb(null);
+        }
+
+        sess.send(`v8 inspect ${addresses[name]}`);
+        sess.linesUntil(/\}>/, (err, lines) => {
+          if (err) return cb(err);
+          lines = lines.join('\n');
+          t.ok(/\[0\]=0x[0-9a-f]+:<String: "a"> => <Smi: 1>/.test(lines),
+               'map should have its first entry');
+          t.ok(/\[1\]=0x[0-9a-f]+:<String: "c"> => <Smi: 3>/.test(lines),
+               'map should skip the deleted entry');
+          cb(null);
+        });
+      });
+    }
+  },
+  // .set=0x000003df9cbe8231:<JSSet: size=3>
+  'set': {
+    re: /\.set=(0x[0-9a-f]+):<(?:JSSet: size=3|unknown)>/,
+    desc: '.set JSSet property'
   }
 
 };
@@ -1,23 +1,37 @@
 'use strict';
 
+const os = require('os');
+const path = require('path');
 const tape = require('tape');
 const common = require('../common');
 const versionMark = common.versionMark;
 
+// A smaller heap for v8 heapdiff to compare against, only saved along with
+// the core of scan-scenario.js so both come from the same executable.
+const baselineCore = path.join(os.tmpdir(), 'core-heapdiff-baseline');
+
 tape('v8 findrefs and friends', (t) => {
   t.timeoutAfter(common.saveCoreTimeout);
 
   // Use prepared core and executable to test
   if (process.env.LLNODE_CORE && process.env.LLNODE_NODE_EXE) {
-    test(process.env.LLNODE_NODE_EXE, process.env.LLNODE_CORE, t);
+    test(process.env.LLNODE_NODE_EXE, process.env.LLNODE_CORE, null, t);
   } else {
     common.saveCore({
-      scenario: 'scan-scenario.js'
+      scenario: 'heapdiff-scenario.js',
+      core: baselineCore
     }, (err) => {
       t.error(err);
-      t.ok(true, 'Saved core');
+      t.ok(true, 'Saved baseline core');
+
+      common.saveCore({
+        scenario: 'scan-scenario.js'
+      }, (err) => {
+        t.error(err);
+        t.ok(true, 'Saved core');
 
-      test(process.execPath, common.core, t);
+        test(process.execPath, common.core, baselineCore, t);
+      });
     });
   }
 });
@@ -34,7 +48,7 @@ function testFindrefsForInvalidExpr(t, sess, next) {
   });
 }
 
-function test(executable, core, t) {
+function test(executable, core, baseline, t) {
   const sess = common.Session.loadCore(executable, core, (err) => {
     t.error(err);
     t.ok(true, 'Loaded core');
@@ -58,11 +72,172 @@ function test(executable, core, t) {
     t.ok(/3 +0 Class: x, y, hashmap/.test(lines.join('\n')),
          '"Class: x, y, hashmap" should be in findjsobjects -d');
 
-    sess.send('v8 findjsinstances Class_B')
+    sess.send('v8 findjsobjects --by-site');
+    // Just a separator
+    sess.send('version');
+  });
+
+  sess.linesUntil(versionMark, (err, lines) => {
+    t.error(err);
+    t.ok(/ 10 +\d+ Class_B at .*scan-scenario\.js:\d+:\d+/.test(lines.join('\n')),
+         'Class_B constructor should be in findjsobjects --by-site');
+
+    sess.send('v8 findjsobjects --histograms');
+    // Just a separator
+    sess.send('version');
+  });
+
+  sess.linesUntil(versionMark, (err, lines) => {
+    t.error(err);
+    const output = lines.join('\n');
+    t.ok(/Array lengths:\n/.test(output) &&
+         /String lengths:\n/.test(output),
+         'findjsobjects --histograms should print the histograms');
+    // Up to the blank line before the next histogram
+    const arrays = output.split('Array lengths:\n')[1] || '';
+    const buckets = arrays.split('\n\n')[0];
+    t.ok(/\n +9 - 64 +[1-9]\d* +\d+\.\d+% +\d+(\n|$)/.test(buckets),
+         'the array of ten Class_B should be in a 9 - 64 bucket');
+
+    sess.send('v8 heapspaces');
+    // Just a separator
+    sess.send('version');
+  });
+
+  sess.linesUntil(versionMark, (err, lines) => {
+    t.error(err);
+    const output = lines.join('\n');
+    t.ok(/ old +\d+ +\d+ +\d+ +\d+/.test(output),
+         'old space should be in heapspaces');
+    t.ok(/ total +[1-9]\d* +\d+/.test(output),
+         'heapspaces should find at least one page');
+
+    sess.send('v8 duplicatestrings');
     // Just a separator
     sess.send('version');
   });
 
+  sess.linesUntil(versionMark, (err, lines) => {
+    t.error(err);
+    const output = lines.join('\n');
+    t.ok(/ 10 +\d+ +23 <String: "duplicated strin/.test(output),
+         'duplicated string should be in duplicatestrings');
+    t.ok(/0x[0-9a-f]+ \(1 referrers\)/.test(output),
+         'duplicatestrings should count referrers of samples');
+
+    sess.send('v8 arraybuffers');
+    // Just a separator
+    sess.send('version');
+  });
+
+  sess.linesUntil(versionMark, (err, lines) => {
+    t.error(err);
+    const output = lines.join('\n');
+    t.ok(/\d+ ArrayBuffers \(\d+ detached\)/.test(output),
+         'arraybuffers should print a summary');
+    t.ok(/ 1048576 +2 0x[0-9a-f]+ 0x[0-9a-f]+/.test(output),
+         'ArrayBuffer with two views should be in arraybuffers');
+
+    sess.send('v8 collections -n 5');
+    // Just a separator
+    sess.send('version');
+  });
+
+  sess.linesUntil(versionMark, (err, lines) => {
+    t.error(err);
+    const output = lines.join('\n');
+    t.ok(/\d+ collections, \d+ entries in \d+ bytes of hash tables/
+             .test(output),
+         'collections should print a summary');
+    t.ok(/\n +5000 +\d+  Map +0x[0-9a-f]+/.test(output),
+         'the 5000 entries Map should be in collections');
+
+    sess.send('v8 contexts --top 50');
+    // Just a separator
+    sess.send('version');
+  });
+
+  sess.linesUntil(versionMark, (err, lines) => {
+    t.error(err);
+    const output = lines.join('\n');
+    t.ok(/\d+ function contexts from \d+ functions/.test(output),
+         'contexts should print a summary');
+    t.ok(/ +\d+ +\d+ +\d+ 0x[0-9a-f]+  closure: scoped\w+=0x[0-9a-f]+/.test(output),
+         'closure() context should be in contexts');
+
+    sess.send('v8 promises');
+    // Just a separator
+    sess.send('version');
+  });
+
+  sess.linesUntil(versionMark, (err, lines) => {
+    t.error(err);
+    const output = lines.join('\n');
+    t.ok(/\d+ promises: \d+ pending, \d+ fulfilled, \d+ rejected/.test(output),
+         'promises should print a summary');
+    const chain = output.match(/\n +(\d+) 0x[0-9a-f]+ 0x[0-9a-f]+ /);
+    t.ok(chain && parseInt(chain[1], 10) >= 11,
+         'the chain of eleven pending promises should be in promises');
+
+    sess.send('v8 maps');
+    // Just a separator
+    sess.send('version');
+  });
+
+  sess.linesUntil(versionMark, (err, lines) => {
+    t.error(err);
+    const output = lines.join('\n');
+    t.ok(/\d+ maps used by \d+ objects, \d+ objects in dictionary mode/
+             .test(output),
+         'maps should print a summary');
+    t.ok(/\n +10 +\d+  Dictionary at .*scan-scenario\.js:\d+:\d+/.test(output),
+         'Dictionary instances should be in dictionary mode');
+
+    // Diffing the core against itself should find no growth
+    sess.send(`v8 heapdiff ${core} ${executable}`);
+    // Just a separator
+    sess.send('version');
+  });
+
+  sess.linesUntil(versionMark, (err, lines) => {
+    t.error(err);
+    const output = lines.join('\n');
+    t.ok(/\d+ objects \(\d+ bytes\) now: \+0 objects, \+0 bytes/.test(output),
+         'heapdiff should print a summary without growth');
+
+    // Prepared cores come without a baseline of their own
+    if (baseline) {
+      sess.send(`v8 heapdiff -n 100000 ${baseline} ${executable}`);
+    } else {
+      sess.send('v8 findjsinstances Class_B');
+    }
+    // Just a separator
+    sess.send('version');
+  });
+
+  if (baseline) {
+    sess.linesUntil(versionMark, (err, lines) => {
+      t.error(err);
+      const output = lines.join('\n');
+      t.ok(/ now: \+[1-9]\d* objects, \+[1-9]\d* bytes/.test(output),
+           'heapdiff should print the growth from the baseline');
+
+      const [types, sites] = output.split('\nSites:\n');
+      const samples = /\n +new:( 0x[0-9a-f]{16}){3}\n/.source;
+      const row = (name) =>
+        new RegExp(/\n +\+10 +\+\d+ +10 +\d+ /.source + name + samples);
+      const site = /Class_B at .*scan-scenario\.js:\d+:\d+/.source;
+      t.ok(row('Class_B').test(types),
+           'the ten new Class_B should be in the types with samples');
+      t.ok(row(site).test(sites || ''),
+           'the ten new Class_B should be in the sites with samples');
+
+      sess.send('v8 findjsinstances Class_B')
+      // Just a separator
+      sess.send('version');
+    });
+  }
+
   sess.linesUntil(versionMark, (err, lines) => {
     t.error(err);
 
@@ -96,13 +271,15 @@ function test(executable, core, t) {
   });
 
   // Test for recursive findrefs, a new `Class_C` was introduced in `inspect-scenario.js`
+  let classB;
   sess.linesUntil(versionMark, (err, lines) => {
     t.error(err);
 
     for (let i=0; i < lines.length; i++) {
       const match = lines[i].match(/(0x[0-9a-f]+):<Object: Class_B>/i);
       if (match) {
-        sess.send(`v8 findrefs -r ${match[1]}`);
+        classB = match[1];
+        sess.send(`v8 findrefs -r ${classB}`);
         break;
       }
     }
@@ -114,6 +291,18 @@ function test(executable, core, t) {
   sess.linesUntil(versionMark, (err, lines) => {
     t.error(err);
     t.ok(/Class_C\.arr/.test(lines.join('\n')), 'Should find parent reference' );
+    sess.send(`v8 retainers ${classB}`);
+    sess.send('version');
+  });
+
+  // Test for retainers, the paths should go through the same parent
+  sess.linesUntil(versionMark, (err, lines) => {
+    t.error(err);
+    const output = lines.join('\n');
+    t.ok(/\d+ retaining paths? for 0x[0-9a-f]+/.test(output),
+         'Should print the retaining paths');
+    t.ok(/ #1 .+, \d+ edges?/.test(output), 'Should find a root');
+    t.ok(/Class_C\.arr=/.test(output), 'Should retain through parent');
     sess.send('v8 findrefs -n my_class_c');
     sess.send('version');
   });
@@ -130,6 +319,16 @@ function test(executable, core, t) {
   sess.linesUntil(versionMark, (err, lines) => {
     t.error(err);
     t.ok(/Class_C\.arr/.test(lines.join('\n')), 'Should find parent reference with -r -n' );
+    sess.send('v8 findrefs -n my_class_b --depth 1');
+    sess.send('version');
+  });
+
+  // Test for --depth, the parents of the referrers aren't expanded
+  sess.linesUntil(versionMark, (err, lines) => {
+    t.error(err);
+    t.ok(/\[depth limit\]/.test(lines.join('\n')), 'Should stop at --depth');
+    t.notOk(/Class_C\.arr/.test(lines.join('\n')),
+            'Should not walk below --depth');
     // TODO(mmarchini) see comment below
     // sess.send('v8 findrefs -s "My Class C"');
     sess.send('v8 findjsinstances Zlib');
@@ -8,11 +8,18 @@ function testWorkqueueCommands(t, sess) {
   sess.send('v8 getactivehandles');
 
   sess.wait(/TCP/, (err, line) => {
+    t.error(err);
+    t.ok(/\d+\s+TCP/.test(line), 'TCP handles should be counted');
+
+    sess.send('v8 getactivehandles -d -n 10');
+  });
+
+  sess.wait(/<Object: TCP/, (err, line) => {
     t.error(err);
     let match = line.match(/<Object: TCP/i);
     t.ok(match, 'TCP handler should be an Object');
 
-    sess.send('v8 getactiverequests');
+    sess.send('v8 getactiverequests -d');
   });
 
   sess.wait(/FSReq[a-zA-Z]*/, (err, line) => {
@@ -20,8 +27,52 @@ function testWorkqueueCommands(t, sess) {
     let match = line.match(/<Object: FSReq[a-zA-Z]*/i);
     t.ok(match, 'FSReq[a-zA-Z]* handler should be an Object');
 
-    sess.quit();
-    t.end();
+    sess.send('v8 getactivehandles --all');
+    sess.wait(/Environment 0x[0-9a-f]+:/, (err, line) => {
+      t.error(err);
+
+      sess.wait(/TCP/, (err, line) => {
+        t.error(err);
+        t.ok(/\d+\s+TCP/.test(line),
+             'TCP handles should be found with --all');
+
+        testEventLoop(t, sess);
+      });
+    });
+  });
+}
+
+function testEventLoop(t, sess) {
+  sess.send('v8 eventloop -d');
+  sess.wait(/Loop 0x[0-9a-f]+: \d+ handles/, (err, line) => {
+    t.error(err);
+
+    sess.wait(/\d+\s+\d+\s+\d+\s+TCP/, (err, line) => {
+      t.error(err);
+      t.ok(line, 'uv handles should be counted by type');
+
+      sess.wait(/0x[0-9a-f]+ TCP\s+active ref fd=\d+/, (err, line) => {
+        t.error(err);
+        t.ok(line, 'the listening socket should have a file descriptor');
+
+        testTimers(t, sess);
+      });
+    });
+  });
+}
+
+function testTimers(t, sess) {
+  sess.send('v8 timers');
+  sess.wait(/\d+ active timers/, (err, line) => {
+    t.error(err);
+
+    sess.wait(/^\s+500\s+1\s+1\s/, (err, line) => {
+      t.error(err);
+      t.ok(line, 'the interval should be grouped by its duration');
+
+      sess.quit();
+      t.end();
+    });
   });
 }
 